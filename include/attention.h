@@ -0,0 +1,19 @@
+#ifndef ATTENTION_H
+#define ATTENTION_H
+#include "simulator.h"
+
+#define MAX_ATTENTION_LENGTHS 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 把网络中每个attention层的序列长度依次设为lengths中的n个值(解码层seq_len为1时只改kv_len)，
+   比较naive(分数矩阵写到片外)与tiled(在线softmax，分数留在片上)两种实现的片外访存量、延迟和瓶颈，
+   并给出tiled实现的块大小和k/v读取遍数 */
+void attention_report(asic *hardware, network *net, float *lengths, int n);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
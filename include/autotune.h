@@ -0,0 +1,23 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+#include "simulator.h"
+
+#define MAX_IMPLS 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 列出算子所有可选的实现(alu、泰勒展开或surpass、卷积算法、attention算法、权重分块大小)，返回个数
+int layer_candidates(asic *hardware, layer *l, layer_impl *out);
+/* 第i层能否与第i+1层融合：第i+1层是其唯一的消费者(后面没有shortcut或route再引用它)，
+   且中间结果放得下一半片上缓存，或者下一层是逐元素算子可以边算边消费 */
+int can_fuse(asic *hardware, network *net, int i);
+/* 对整个网络的逐层实现做动态规划(状态为输入是否已在片上)，输出延迟最低的方案，
+   并与默认实现对比；每层延迟按计算与访存重叠取较大者累加 */
+void autotune_report(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,19 @@
+#ifndef CALIBRATE_H
+#define CALIBRATE_H
+#include "simulator.h"
+
+#define MAX_PARAMS 24
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 从csv读取实测延迟(每行"网络cfg,层号,延迟(in us)"，层号为-1或all表示整个网络)，
+   用最小二乘(按相对误差)拟合average_alu_efficiency、average_bandwidth_efficiency、surpass_efficiency，
+   以及每种算子类型各自的alu效率，报告拟合前后的残差 */
+void calibrate_report(asic *hardware, char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,21 @@
+#ifndef COLOCATE_H
+#define COLOCATE_H
+#include "simulator.h"
+
+#define MAX_MODELS 8
+#define MAX_SLOTS 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 返回只拥有compute份额的alu(tensor/vector/surpass)和bandwidth份额的片外带宽的那部分硬件
+asic partition_asic(asic *hardware, float compute, float bandwidth);
+/* 在一个asic上同时部署n个网络，分别按空间划分(按step等分alu和带宽)和分时复用(每轮每个网络
+   运行1~MAX_SLOTS次)搜索在各网络延迟都不超过slo(in us, 0表示不限)时总吞吐最高的划分 */
+void colocate_report(asic *hardware, network *nets, char **names, int n, float *slo, int step);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,17 @@
+#ifndef CONV_H
+#define CONV_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 对网络中每个卷积层比较直接卷积、im2col、winograd F(2,3)/F(4,3)和fft中能用的算法：tensor alu上的乘加、
+   vector alu上的展开或变换、片外访存的时间和瓶颈，标出auto选中的算法；再给出整个网络
+   各层都用同一算法(不能用时用直接卷积)和按层auto时各单元的总时间与瓶颈 */
+void conv_report(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
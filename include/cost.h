@@ -0,0 +1,60 @@
+#ifndef COST_H
+#define COST_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// dtype编号转为字节数：1为half(2字节)，2为float(4字节)
+int dtype_size(int dtype);
+char *get_unit_string(UNIT_TYPE unit);
+char *get_conv_string(CONV_ALGO a);
+CONV_ALGO get_conv_algo(char *s);
+// 卷积能否用算法a计算：winograd只用于3x3、步长1、不分组的卷积，fft用于大于1x1、步长1、不分组的卷积
+int conv_algo_applies(layer *l, CONV_ALGO a);
+// 算法a在硬件的mac数据类型下是否足够精确：winograd F(4,3)的变换矩阵在半精度下误差过大，只用于fp32
+int conv_algo_exact(asic *hardware, CONV_ALGO a);
+// 对应alu的流水效率，直接用1/(阻塞拍数+1)表示
+float pipe_efficiency(asic *hardware, UNIT_TYPE unit);
+/* alu时间与之成反比的效率参数(in %)：surpass为surpass_efficiency，有阵列的tensor为100(利用率由映射决定)，
+   其余为average_alu_efficiency；设置了算子类型效率时由它代替 */
+float unit_efficiency(asic *hardware, UNIT_TYPE unit);
+// 在unit上以效率eff(0~1)完成ops次运算所需的时间(in us)
+float alu_time(asic *hardware, UNIT_TYPE unit, float ops, float eff);
+// 以带宽效率eff(0~1)从片外搬运mem字节所需的时间(in us)
+float mem_time(asic *hardware, float mem, float eff);
+// 循环层(rnn/lstm)每个时间步都要用到的递归权重(W)字节数
+float recurrent_weight_bytes(asic *hardware, layer *l);
+// 其中能常驻片上buffer(留出两个tile用于输入输出)的字节数，其余每个时间步重新从片外读取
+float resident_weight_bytes(asic *hardware, layer *l);
+// attention每个query看到的key数，设置了滑动窗口window时不超过window
+float attention_span(layer *l);
+// attention层为一个batch保存的k/v cache字节数，kv_heads个head，滑动窗口时只保留最近window个token
+float kv_cache_bytes(asic *hardware, layer *l);
+/* tiled attention一个head的q块与k/v块的行数：q块、输出累加(fp32)、k和v块以及分数块(fp32)同时放在片上buffer中，
+   passes为每个head的k/v从片外读取的遍数，整个head的k/v能和一个q块一起放下时为1 */
+int attention_block(asic *hardware, layer *l, int *passes);
+// moe层的专家在期望负载下(不按impl->loads时)每个专家分到的token数，以及至少分到一个token的概率
+void moe_expected_loads(layer *l, float *loads, float *active);
+/* embedding查表命中片上热行缓存的比例：设置了hit_rate时直接使用，否则缓存(不超过片上buffer)按行热度
+   存放最热的行，热度为均匀分布或按行序号的zipf分布 */
+float embedding_hit_rate(asic *hardware, layer *l);
+// 在impl的其余选择下，卷积层能用且足够精确的算法中(按cost_layer_impl)最快的一个
+CONV_ALGO fastest_conv(asic *hardware, layer *l, layer_impl impl);
+/* 算子的默认实现：卷积/全连接/rnn/lstm用tensor alu计算，其余用vector alu，没有surpass alu时用泰勒展开，
+   卷积和attention按cfg中的algo，卷积为auto时取最快的算法 */
+layer_impl default_impl(asic *hardware, layer *l);
+// 算子计算与访存重叠时的延迟(roofline)，即两者中较大的一个(in us)
+float layer_latency(layer_cost *c);
+// 计算单个算子按默认实现的运算量、访存量、利用率以及计算和访存时间
+layer_cost cost_layer(asic *hardware, layer *l);
+// 按指定实现(alu、泰勒展开或surpass、卷积算法、权重分块大小、与前后层融合)计算单个算子的代价
+layer_cost cost_layer_impl(asic *hardware, layer *l, layer_impl *impl);
+// 汇总整个模型(块内的层重复net->blocks次)的运算量、访存量、计算/访存时间以及峰值、最差性能和能耗
+net_cost cost_network(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,22 @@
+#ifndef DIMS_H
+#define DIMS_H
+#include "simulator.h"
+#include "list.h"
+
+#define MAX_DIM_VALUES 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 解析"S=v1,v2,..."或"S=lo:hi:n"形式的符号维度取值，name至少32字节，返回取值个数 */
+int parse_dim(char *s, char *name, float *values, int max);
+/* 符号name依次取values中的n个值，每次从已读取的sections重新构建网络(不重新读文件)，
+   报告运算量、访存量、激活内存、延迟、瓶颈以及attention占比随之变化的曲线，
+   并给出相邻两点间延迟的增长阶数 */
+void dims_report(asic *hardware, list *sections, char *name, float *values, int n);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,26 @@
+#ifndef DRAM_H
+#define DRAM_H
+#include "simulator.h"
+
+//dram channels are interleaved at this granularity(in bytes)
+#define DRAM_INTERLEAVE 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+char *get_access_string(ACCESS_PATTERN a);
+// 是否配置了dram模型(dram_page > 0)，否则退回到average_bandwidth_efficiency
+int has_dram_model(asic *hardware);
+// 每段连续访问run字节时burst和行缓冲决定的效率(0~1)，不含通道并行，事件引擎自行建模通道
+float dram_access_efficiency(asic *hardware, ACCESS_PATTERN pattern, float run);
+/* 一段访存流的可达带宽效率(0~1)：bytes为总字节数，run为每段连续访问的字节数(<=0表示整段连续)，
+   考虑burst粒度浪费、行缓冲命中/缺失(缺失开销由bank并行掩盖一部分)以及小访存无法铺满所有通道 */
+float dram_efficiency(asic *hardware, ACCESS_PATTERN pattern, float bytes, float run);
+// requests个相互独立的随机访问受访存延迟限制的时间(in us)：每个等待offchip_latency，同时最多outstanding_requests个
+float gather_latency_time(asic *hardware, float requests);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,22 @@
+#ifndef DVFS_H
+#define DVFS_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 返回工作在第k个电压/频率点上的硬件：频率和功耗取该点的值，片上能耗按电压平方缩放，漏电按电压线性缩放
+asic at_operating_point(asic *hardware, int k);
+// 平均功耗pwr(in W)持续运行时的稳态温度(in C)
+float steady_temperature(asic *hardware, float pwr);
+// 从环境温度开始以pwr持续运行，多久(in s)达到降频温度，不会降频时返回-1
+float throttle_time(asic *hardware, float pwr);
+/* 在每个工作点上评估网络的延迟、能耗、功耗和温度，按热模型给出持续运行时实际降到的工作点，
+   并为每个算子挑选在延迟损失不超过slack(in %)时能耗最低的工作点 */
+void dvfs_report(asic *hardware, network *net, float slack);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
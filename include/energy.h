@@ -0,0 +1,19 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 是否配置了能耗模型(任一energy_*字段或static_power大于0)，否则只能用恒定的power估计
+int has_energy_model(asic *hardware);
+// 算子的动态能耗(in uJ)：运算按所在alu和数据类型计，片外字节计dram能耗，并在片上缓存写入读出各一次
+float layer_energy(asic *hardware, layer_cost *c);
+// 持续latency(in us)的静态漏电能耗(in uJ)
+float static_energy(asic *hardware, float latency);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
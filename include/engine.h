@@ -0,0 +1,85 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+#include "simulator.h"
+#include "event.h"
+
+// 时间线上的轨道：三种alu沿用UNIT_TYPE的编号，DMA为第四条
+#define DMA_TRACK 3
+#define NUM_TRACKS 4
+
+typedef enum {
+    INST_LOAD,
+    INST_COMPUTE,
+    INST_STORE
+} INST_TYPE;
+
+// 一条tile级指令在时间线上的执行区间
+typedef struct slice {
+    INST_TYPE type;
+    int track;
+    int layer;
+    int tile;
+    float amount;    //ops for compute, bytes for load/store
+    double start;    //in us
+    double end;      //in us
+} slice;
+
+typedef struct timeline {
+    int n;
+    int size;
+    slice *slices;
+} timeline;
+
+// tile级指令，succ为依赖该指令的其它指令，字段按大小排列使一条指令只占32字节
+typedef struct instruction {
+    double start;
+    float amount;
+    int tile;
+    int succ[3];
+    short deps;
+    char nsucc;
+    char type;
+} instruction;
+
+// 就绪指令的环形队列
+typedef struct inst_fifo {
+    int head;
+    int n;
+    int size;
+    int *ids;
+} inst_fifo;
+
+typedef struct engine {
+    asic *hardware;
+    event_queue *events;
+    timeline *trace;          //NULL when no timeline is recorded
+    double now;               //in us
+    double *channel_free;     //time each dram channel becomes idle
+    int next_channel;
+    int busy[NUM_TRACKS];     //instructions running on each track
+    double busy_time[NUM_TRACKS];
+    long nevents;
+    long ntiles;
+    double wall;              //host time spent simulating(in s)
+} engine;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+timeline *make_timeline();
+void timeline_insert(timeline *t, slice s);
+void free_timeline(timeline *t);
+
+// 创建离散事件引擎，trace不为NULL时记录每条指令的执行区间
+engine *make_engine(asic *hardware, timeline *trace);
+// 将算子降级为tile级的load/compute/store指令并仿真，返回算子完成的时刻(in us)
+double simulate_layer(engine *e, layer_cost c, int index);
+// 输出仿真得到的周期数、各单元的繁忙比例以及事件吞吐
+void print_engine(engine *e);
+void free_engine(engine *e);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,33 @@
+#ifndef EVENT_H
+#define EVENT_H
+#include "simulator.h"
+
+typedef struct event {
+    double time;     //time the event fires(in us)
+    uint64_t seq;    //insertion order, keeps events at the same time FIFO
+    int id;          //instruction the event belongs to
+} event;
+
+// 以二叉小顶堆实现的事件优先队列
+typedef struct event_queue {
+    int n;
+    int size;
+    uint64_t seq;
+    event *heap;
+} event_queue;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+event_queue *make_event_queue(int size);
+// 插入一个在time时刻触发的事件，堆满时自动扩容
+void push_event(event_queue *q, double time, int id);
+// 弹出最早触发的事件，队列为空时不可调用
+event pop_event(event_queue *q);
+void free_event_queue(event_queue *q);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
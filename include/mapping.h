@@ -0,0 +1,25 @@
+#ifndef MAPPING_H
+#define MAPPING_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 将cfg中的dataflow字符串转为枚举类别，无法识别时使用weight_stationary
+DATAFLOW get_dataflow(char *s);
+char *get_dataflow_string(DATAFLOW d);
+
+// 阵列是否以rows×cols描述，否则退回到扁平的mac_num + average_alu_efficiency模型
+int has_mac_array(asic *hardware);
+
+/* 将一个m×n×k的矩阵乘(m行输入，n个输出，k为累加维度)按dataflow映射到rows×cols阵列上，
+   返回阵列利用率(0~1)，包含维度不能整除阵列时的padding浪费以及阵列的填充/排空开销 */
+float gemm_utilisation(asic *hardware, int m, int n, int k);
+// 卷积的阵列利用率，row stationary时按Eyeriss方式映射，其余数据流按im2col后的矩阵乘映射
+float conv_utilisation(asic *hardware, layer *l);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
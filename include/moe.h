@@ -0,0 +1,20 @@
+#ifndef MOE_H
+#define MOE_H
+#include "simulator.h"
+
+#define MOE_TRIALS 256          //routing draws per moe layer
+#define MOE_SEED 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 对每个moe层按路由分布随机抽取MOE_TRIALS次token到专家的分配(每个token选top_k个不同专家)，
+   用每次的实际负载计算延迟，报告期望负载下的延迟、抽样延迟的均值/P50/P99/最大值、
+   活跃专家数和最大负载相对平均负载的不均衡程度 */
+void moe_report(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
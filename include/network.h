@@ -7,6 +7,15 @@ extern "C" {
 #endif
 
 network make_network(int n);
+// 将算子枚举类别转为输出用的名字
+char *get_layer_string(LAYER_TYPE a);
+// 设置网络各层(包括rnn/lstm的子层)的batch大小，之后无需重新解析即可按新的batch评估
+void set_batch_network(network *net, int b);
+/* 设置网络各层每个样本的token数(rnn/lstm的时间步不变)，例如推测解码一次验证多个token；
+   attention的kv_len至少覆盖这些token */
+void set_tokens_network(network *net, int tokens);
+// 一层在整个模型中执行的次数：块内的层重复net->blocks次，once=1的层(embedding、lm head)只执行一次
+int layer_repeats(network *net, layer *l);
 void free_sublayer(layer *l);
 void free_layer(layer l);
 void free_network(network net);
@@ -3,6 +3,8 @@
 #include "simulator.h"
 #include "list.h"
 
+#define MAX_SYMBOLS 16
+
 typedef struct{
     char *key;
     char *val;
@@ -33,6 +35,15 @@ float option_find_float(list *l, char *key, float def);
 float option_find_float_quiet(list *l, char *key, float def);
 // 在list l中寻找unused的节点，打印相关键值对
 void option_unused(list *l);
+/* 符号维度：整数字段的值可以写成符号或含符号的四则表达式(如S、2*S、S/2+1)，
+   bind_symbol绑定取值(命令行或扫描)，define_symbol只在符号未绑定时给出cfg中的默认值 */
+void bind_symbol(char *name, int value);
+void define_symbol(char *name, int value);
+// 记下当前的符号表，restore_symbols丢弃此后define_symbol加入的cfg默认值，使一个cfg的默认值不影响之后解析的cfg
+int save_symbols();
+void restore_symbols(int saved);
+// 求整数表达式的值，表达式中的符号必须已经绑定
+int eval_dim(char *s);
 
 #ifdef __cplusplus
 }
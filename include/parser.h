@@ -16,6 +16,7 @@ typedef struct size_params{
     int c;  //channels
     int index;
     int time_steps;
+    int seq_len;
     int train;
     network net;
 } size_params;
@@ -32,8 +33,22 @@ layer parse_relu(list *options, size_params params);
 layer parse_lrn(list *options, size_params params);
 layer parse_deconv(list *options, size_params params);
 layer parse_unpool(list *options, size_params params);
+layer parse_shortcut(list *options, size_params params);
+layer parse_route(list *options, size_params params);
+layer parse_attention(list *options, size_params params);
+/* moe各专家分到的路由token比例(和为1)：uniform均匀，zipf按专家序号的s次幂反比，
+   其他取值为每个专家token计数的直方图文件(逗号或换行分隔) */
+float *routing_distribution(char *routing, float s, int experts);
+layer parse_moe(list *options, size_params params);
+layer parse_embedding(list *options, size_params params);
 
 network parse_network_cfg(char *filename);
+// 读取cfg文件的各个section(每个section为类型和键值对链表)
+list *read_cfg(char *filename);
+void free_sections(list *sections);
+/* 从已读取的section构建网络，section保持不变，可以在重新绑定符号维度后再次构建，
+   形状随符号的取值逐层传播 */
+network parse_network_sections(list *sections);
 void parse_hardware_cfg(char *filename, asic *hardware);
 
 #ifdef __cplusplus
@@ -0,0 +1,29 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 一个算子在跨层流水中的时间线
+typedef struct prefetch_layer {
+    float start;        //in us
+    float end;
+    float compute;      //alu time
+    float load;         //weight load time in isolation
+    float prefetched;   //weight bytes already on chip when the layer starts
+    float stall;        //time the layer waits on memory beyond its compute
+} prefetch_layer;
+
+/* 按层序仿真一个buffer KB的预取缓冲：每层先完成自己的访存，DMA在该层剩余的计算时间内
+   把后续各层的权重按顺序预取进缓冲，层开始时未预取到的权重再随该层流式读入；
+   layers非0时记录每层的时间线，返回网络延迟(in us) */
+float prefetch_network(asic *hardware, network *net, float buffer, prefetch_layer *layers);
+// 对比逐层隔离、预取流水和网络级上下界的延迟，给出隐藏的权重读取时间、仍在等待访存的算子和不同缓冲大小的延迟
+void prefetch_report(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,54 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+#include <stddef.h>
+
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PROFILE_PARSE,      //parse_network_cfg and parse_hardware_cfg, including the two below
+    PROFILE_READ_CFG,   //read_cfg, the file read line by line with fgetl
+    PROFILE_OPTIONS,    //option_find lookups
+    PROFILE_COST,       //the layer loop of operations()
+    PROFILE_ENGINE,     //event simulation
+    PROFILE_ANALYSIS,   //dvfs, tuning, serving, co-location, calibration
+    PROFILE_OUTPUT,     //formatting the reports
+    NUM_PROFILE_PHASES
+} PROFILE_PHASE;
+
+typedef struct profile {
+    int enabled;
+    double begin;
+    double start[NUM_PROFILE_PHASES];
+    double total[NUM_PROFILE_PHASES];
+    long calls[NUM_PROFILE_PHASES];
+} profile;
+
+//counters bumped on hot paths, kept per thread so that sweep workers don't share them
+typedef struct profile_counters {
+    long allocations;
+    size_t allocated;   //bytes requested from xmalloc, xcalloc and xrealloc
+    long layers;        //cost_layer evaluations
+    long networks;      //cost_network evaluations
+} profile_counters;
+
+extern profile prof;
+extern __thread profile_counters prof_count;
+
+// 开启计时，计数器始终在统计
+void enable_profile();
+// 单调时钟计时的开始和结束，同一阶段不可嵌套；未开启时直接返回
+void profile_begin(PROFILE_PHASE p);
+void profile_end(PROFILE_PHASE p);
+// 把工作线程退出前的计数器c累加到当前线程，由主线程在join之后调用
+void profile_add(profile_counters *c);
+// 打印各阶段耗时、调用次数、内存分配和每秒评估的算子数
+void print_profile();
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,20 @@
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+#include "simulator.h"
+
+#define MAX_KNOBS 16
+#define SENSITIVITY_TOP 5
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 网络端到端延迟和能耗对各硬件字段(alu数、带宽、频率、效率、片上buffer)的偏导数，通过完整代价模型求差分
+   (浮点字段取千分之一的中心差分，整数字段取增加一个单位的前向差分)，给出弹性系数和按面积折算的收益，
+   并按每个参数对各算子延迟的帮助大小排序 */
+void sensitivity_report(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
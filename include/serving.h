@@ -0,0 +1,43 @@
+#ifndef SERVING_H
+#define SERVING_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    STATIC_BATCH, DYNAMIC_BATCH, CONTINUOUS_BATCH
+} BATCH_POLICY;
+
+typedef struct request {
+    double arrival;     //in us
+    int length;         //iterations of the network the request needs, e.g. decoded tokens
+    double finish;
+} request;
+
+typedef struct serving_config {
+    BATCH_POLICY policy;
+    float rate;         //poisson arrival rate in requests/s
+    int requests;
+    int max_batch;
+    float timeout;      //in us, how long a dynamic batch waits to fill
+    int length;         //iterations per request for poisson arrivals
+    char *arrivals;     //csv trace of "timestamp_us,length", replaces the poisson process
+    unsigned int seed;
+} serving_config;
+
+BATCH_POLICY get_batch_policy(char *s);
+char *get_batch_policy_string(BATCH_POLICY p);
+// 读取到达轨迹文件，每行为"到达时间(in us),迭代次数"，返回请求数组并把个数写入n
+request *read_arrivals(char *filename, int *n);
+// 按泊松过程生成n个请求，rate为每秒请求数
+request *poisson_arrivals(int n, float rate, int length, unsigned int seed);
+/* 用代价模型给出的各batch大小下的网络延迟模拟单个asic上的请求队列，
+   按批处理策略(静态、带超时的动态、逐迭代的连续批处理)报告p50/p99/p999延迟和持续吞吐 */
+void serving_report(asic *hardware, network *net, serving_config *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -33,6 +33,13 @@
 
 #define SECRET_NUM -1234
 
+//most voltage/frequency operating points a hardware cfg may list
+#define MAX_OPP 16
+//most memory tiers a hardware cfg may list
+#define MAX_TIERS 8
+//most experts a moe layer may have
+#define MAX_EXPERTS 1024
+
 typedef enum { UNUSED_DEF_VAL } UNUSED_ENUM_TYPE;
 
 #ifdef __cplusplus
@@ -48,6 +55,12 @@ typedef struct layer layer;
 struct asic;
 typedef struct asic asic;
 
+struct layer_cost;
+typedef struct layer_cost layer_cost;
+
+struct net_cost;
+typedef struct net_cost net_cost;
+
 // layer.h
 typedef enum {
     CONVOLUTIONAL,
@@ -66,6 +79,11 @@ typedef enum {
     RELU,
     LRN,
     UNPOOL,
+    SHORTCUT,
+    ROUTE,
+    ATTENTION,
+    MOE,
+    EMBEDDING,
     EMPTY,
     BLANK
 } LAYER_TYPE;
@@ -74,12 +92,33 @@ typedef enum {
 struct layer {
     LAYER_TYPE type;
     layer *share_layer;
+    int batch;
     int inputs;
     int hidden;
     int outputs;
     int h, w, c;
     int out_h, out_w, out_c;
     int n;
+    int seq_len;        //tokens per sample, a transformer's inputs/outputs are per token
+    int kv_len;         //keys and values an attention query looks at
+    int heads;
+    int kv_heads;       //heads of k and v, fewer than heads when queries share them (gqa, mqa)
+    int window;         //keys a query looks back at, 0 for the whole kv_len
+    int experts;
+    int top_k;          //experts each token is routed to
+    int gated;          //experts are gated ffns with three matrices instead of two
+    float *routing;     //each expert's share of the routed tokens, sums to 1
+    int vocab;          //rows of an embedding table
+    int lookups;        //rows an embedding gathers per sample(per token)
+    int pooled;         //gathered rows are summed into one
+    int cache;          //on-chip cache of the hottest rows(in KB), 0 means none
+    float hit_rate;     //fixed fraction of lookups the cache serves, <0 derives it from popularity
+    float zipf;         //zipf exponent of row popularity, 0 means uniform
+    int flash;          //attention tiled with an online softmax, the score matrix stays on chip
+    int conv_algo;      //CONV_ALGO a convolution runs, CONV_AUTO picks the fastest on the hardware
+    int once;           //runs once per model rather than in each of the network's blocks (embedding, lm head)
+    int pad;
+    int index;          //layer a shortcut or route refers to
     int max_boxes;
     int groups;
     int group_id;
@@ -113,16 +152,38 @@ struct layer {
 // network.h
 typedef struct network {
     int n;
+    int batch;
     int h, w, c;
     int inputs;
     int time_steps;
+    int seq_len;
+    int blocks;         //times the cfg repeats to make the whole model, e.g. 32 decoder blocks
     layer *layers;
 } network;
 
 
+// hardware.h
+typedef enum {
+    WEIGHT_STATIONARY,
+    OUTPUT_STATIONARY,
+    ROW_STATIONARY
+} DATAFLOW;
+
+// hardware.h, one level of a memory hierarchy the placement analysis assigns data to
+typedef struct memory_tier {
+    char name[32];
+    float capacity;      //in MB
+    float bw;            //in GB/s
+    float latency;       //per access(in us)
+    float energy;        //per byte(in pJ)
+} memory_tier;
+
 // hardware.h
 typedef struct asic {
     int mac_num;         //tensor alu number
+    int mac_rows;        //rows of the tensor alu array, 0 means a flat array of mac_num alus
+    int mac_cols;        //columns of the tensor alu array
+    DATAFLOW dataflow;   //how operands are pinned on the tensor alu array
     int mac_dtype;       //tensor data type
     int mac_pipeline;    //1 means no stall, 0 means have stalls
     int mac_stall_cycle; //when full_pipeline is 0, this is the number of stall cycles of each cycle
@@ -133,16 +194,126 @@ typedef struct asic {
     int surpass_num;     //surpass alu number
     int surpass_dtype;   //surpass alu data type
     float pwr;           //power(in W)
+    float static_pwr;    //leakage power burnt whether alus are busy or not(in W)
+    float energy_mac_half;   //energy per half mac(in pJ)
+    float energy_mac_float;  //energy per float mac(in pJ)
+    float energy_vec;    //energy per vector alu operation(in pJ)
+    float energy_surpass;    //energy per surpass alu operation(in pJ)
+    float energy_sram;   //energy per on-chip buffer byte read or written(in pJ)
+    float energy_dram;   //energy per offchip byte(in pJ)
     float area;          //area(in mm^2)
+    float mac_area;      //area of one tensor alu(in mm^2), 0 means unknown
+    float vec_area;      //area of one vector alu(in mm^2)
+    float surpass_area;  //area of one surpass alu(in mm^2)
+    float sram_area;     //area of one KB of on-chip buffer(in mm^2)
     float off_bw;        //total bandwidth with DDR(in GB/s)
     float freq;          //frequency
     float ave_alu_eff;   //average alu efficiency(in %)
     float ave_bw_eff;    //average bandwidth efficiency(in %)
     float surpass_eff;   //surpass alu efficiency
+    float type_eff[BLANK + 1];  //per layer type alu efficiency(in %), 0 uses the unit's
     float latency;       //offchip latency (in us)
+    int outstanding;     //offchip requests in flight at once, gathers wait offchip_latency each
+    int opp_num;         //voltage/frequency operating points, 0 means frequency is fixed
+    float opp_volt[MAX_OPP];     //voltage of each point(in V)
+    float opp_freq[MAX_OPP];     //frequency of each point(in GHz)
+    float opp_pwr[MAX_OPP];      //power of each point at full load(in W), 0 means derived from energy
+    float volt;          //voltage the energy_* fields are given at(in V)
+    float tdp;           //sustained power limit(in W), 0 means none
+    float thermal_res;   //junction to ambient thermal resistance(in C/W), 0 means no thermal model
+    float thermal_tau;   //thermal time constant(in s)
+    float ambient;       //ambient temperature(in C)
+    float max_temp;      //temperature the chip throttles at(in C)
+    int dma_num;         //dma engines moving tiles between offchip memory and the on-chip buffer
+    int dram_channels;   //independent dram channels sharing offchip_bandwidth
+    int dram_burst;      //bytes moved per dram burst
+    int dram_page;       //dram row buffer size(in bytes), 0 means no dram model
+    int dram_banks;      //banks per channel overlapping row misses
+    float dram_row_miss; //precharge + activate time of a row miss(in ns)
+    int sram_size;       //on-chip buffer size(in KB)
+    int tile_size;       //tile size the event engine lowers layers to(in KB)
+    int prefetch_size;   //buffer the next layers' weights are prefetched into(in KB)
+    int tier_num;        //[tier] sections after [asic], 0 means the one offchip memory above
+    memory_tier tiers[MAX_TIERS];
 } asic;
 
 
+// dram.h
+typedef enum {
+    SEQUENTIAL,
+    STRIDED,
+    GATHER
+} ACCESS_PATTERN;
+
+// cost.h
+typedef enum {
+    TENSOR_UNIT,
+    VECTOR_UNIT,
+    SURPASS_UNIT
+} UNIT_TYPE;
+
+// cost.h
+typedef enum {
+    CONV_AUTO = -1,      //cfg only, default_impl resolves it to the fastest of the others
+    CONV_DIRECT,
+    CONV_IM2COL,
+    CONV_WINOGRAD2,      //winograd F(2x2,3x3): 4x4 input tiles, 2.25x fewer multiplies
+    CONV_WINOGRAD4,      //winograd F(4x4,3x3): 6x6 input tiles, 4x fewer multiplies, needs fp32
+    CONV_FFT,            //pointwise products of the planes' spectra
+    NUM_CONV_ALGOS
+} CONV_ALGO;
+
+// cost.h
+typedef enum {
+    ATTN_NAIVE,          //scores and probabilities go offchip between the gemms and the softmax
+    ATTN_FLASH           //q and k/v blocks on chip, online softmax rescaling on the vector alu
+} ATTN_ALGO;
+
+// cost.h, how one layer is implemented; cost_layer uses default_impl
+typedef struct layer_impl {
+    UNIT_TYPE unit;      //alu for the main computation
+    int taylor;          //transcendental functions by taylor expansion on the vector alu
+    CONV_ALGO conv;
+    ATTN_ALGO attention;
+    float *loads;        //tokens each moe expert gets in one routing draw, 0 uses the expected loads
+    int tile;            //weight tile kept on chip(in KB), 0 means weights are never refetched
+    int in_onchip;       //input produced on chip by the previous (fused) layer
+    int out_onchip;      //output consumed on chip by the next (fused) layer
+} layer_impl;
+
+// cost.h
+typedef struct layer_cost {
+    UNIT_TYPE unit;      //alu that runs the layer
+    float ops;           //compute operations
+    float aux_ops;       //operations on the vector alu beside the main unit (im2col unfold, transforms, softmax)
+    float surpass_ops;   //operations on the surpass alu beside the main unit (softmax exp)
+    float mem;           //offchip data size(in bytes)
+    float mem_in;        //input activations read from offchip(in bytes)
+    float mem_weight;    //weights read from offchip(in bytes)
+    float mem_out;       //outputs written back offchip(in bytes)
+    ACCESS_PATTERN in_pattern;  //how input activations are read
+    float in_run;        //contiguous bytes per input access, 0 means the whole stream
+    float in_requests;   //independent input gathers, each waits offchip_latency
+    float bw_eff;        //achieved offchip bandwidth efficiency(in %)
+    float energy;        //dynamic energy(in uJ)
+    float util;          //alu efficiency used for the layer(in %)
+    float alu_perf;      //compute time(in us)
+    float aux_perf;      //part of alu_perf spent on aux_ops(in us)
+    float mem_perf;      //offchip access time(in us)
+} layer_cost;
+
+// cost.h
+typedef struct net_cost {
+    float ops;
+    float mem;
+    float alu_perf;      //compute time summed over layers(in us)
+    float mem_perf;      //offchip access time summed over layers(in us)
+    float peak_perf;     //compute and memory fully overlapped(in us)
+    float worst_perf;    //compute and memory serialized(in us)
+    float energy;        //dynamic + static energy at peak_perf(in uJ)
+} net_cost;
+
+
 
 // -----------------------------------------------------
 
@@ -0,0 +1,106 @@
+#ifndef SINK_H
+#define SINK_H
+#include <stdint.h>
+
+#include "simulator.h"
+
+#define MAX_SWEEP_PARAMS 8
+#define MAX_SWEEP_VALUES 256
+#define MAX_TOP_K 64
+#define SINK_CHUNK 4096         //records a worker buffers before one pwrite per column
+#define SINK_HEADER 4096        //header bytes, columns start page aligned after it
+#define HIST_OCTAVE 8           //latency histogram bins per power of two
+#define HIST_MIN_EXP -20        //smallest binned latency is 2^-20 us
+#define HIST_BINS 512
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//metric columns written after the swept parameters
+typedef enum {
+    COL_PEAK,
+    COL_WORST,
+    COL_ALU,
+    COL_MEM,
+    COL_ENERGY,
+    COL_EFFICIENCY,
+    NUM_METRICS
+} SINK_METRIC;
+
+typedef struct sink_record {
+    long index;
+    int value[MAX_SWEEP_PARAMS];    //index of each parameter's value in the grid
+    float metric[NUM_METRICS];
+} sink_record;
+
+//file header, native endian, followed by ncols 32 byte column names
+typedef struct sink_header {
+    char magic[8];              //"SIMSWEEP"
+    int32_t version;
+    int32_t ncols;
+    int64_t rows;
+    int64_t data_offset;        //byte offset of column 0
+    int64_t column_stride;      //bytes between column starts, a multiple of the page size
+} sink_header;
+
+//the k best records by one key, a min heap on key so the root is the first to go
+typedef struct top_k {
+    int n;
+    int k;
+    float key[MAX_TOP_K];
+    sink_record r[MAX_TOP_K];
+} top_k;
+
+//online aggregates, one per worker and a merged one
+typedef struct sink_stats {
+    long n;
+    long hist[HIST_BINS];       //peak latency, log binned
+    double min, max;
+    top_k fastest;
+    top_k efficient;
+    double log_sum[MAX_SWEEP_PARAMS][MAX_SWEEP_VALUES];  //sum of log peak latency per value
+    long count[MAX_SWEEP_PARAMS][MAX_SWEEP_VALUES];
+} sink_stats;
+
+typedef struct sink {
+    int fd;                     //-1 when only aggregating
+    char *filename;
+    long rows;
+    int nparams;
+    int ncols;
+    char *names[MAX_SWEEP_PARAMS];
+    int nvalues[MAX_SWEEP_PARAMS];
+    float *values[MAX_SWEEP_PARAMS];
+    int64_t column_stride;
+    sink_stats stats;
+} sink;
+
+//a worker's buffer of consecutive records, column by column
+typedef struct sink_buffer {
+    long start;
+    int n;
+    float *cols;                //ncols x SINK_CHUNK
+    sink_stats stats;
+} sink_buffer;
+
+char *get_metric_string(SINK_METRIC m);
+/* 建立rows条记录的结果汇，filename非0时创建按列存放的定长二进制文件(每个参数一列，再加各项指标)，
+   文件预先扩展到全部大小，工作线程用pwrite各自写入不重叠的区域；top为保留的最优记录数 */
+sink *open_sink(char *filename, long rows, int nparams, char **names, float **values, int *nvalues, int top);
+// 每个工作线程一个缓冲，无锁
+sink_buffer *make_sink_buffer(sink *s);
+// 记录一个结果并更新线程内的统计，索引不连续或缓冲满时先写出
+void sink_write(sink *s, sink_buffer *b, sink_record *r);
+// 把缓冲中的记录按列pwrite到文件中各自的位置
+void sink_flush(sink *s, sink_buffer *b);
+// 主线程在join之后合并各线程的统计，并释放缓冲
+void sink_merge(sink *s, sink_buffer *b);
+// 打印延迟分布、按延迟和效率的最优记录以及各参数的敏感度
+void sink_report(sink *s);
+void close_sink(sink *s);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,27 @@
+#ifndef SPECULATIVE_H
+#define SPECULATIVE_H
+#include "simulator.h"
+
+#define MAX_DRAFT_TOKENS 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct speculative_config {
+    float accept;       //probability the target accepts each draft token
+    int blocks;         //times the target cfg repeats, e.g. 32 decoder blocks
+    int draft_blocks;   //times the draft cfg repeats
+    int n;              //draft lengths to try
+    int k[MAX_DRAFT_TOKENS];
+} speculative_config;
+
+/* 推测解码：草稿模型逐个生成k个token，目标模型一次验证k+1个token，每个草稿token以accept的概率被接受，
+   每轮期望产出(1-accept^(k+1))/(1-accept)个token；对每个k报告草稿和验证时间、验证的瓶颈、
+   有效tokens/s、相对普通逐token解码的加速比以及加速比为1时的接受率 */
+void speculative_report(asic *hardware, network *target, network *draft, speculative_config *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
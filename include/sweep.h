@@ -0,0 +1,35 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include "simulator.h"
+#include "sink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//cartesian grid over hardware cfg fields, the first parameter varies slowest
+typedef struct sweep_spec {
+    int n;
+    char *keys[MAX_SWEEP_PARAMS];
+    int fields[MAX_SWEEP_PARAMS];       //entry of the settable field table
+    int nvalues[MAX_SWEEP_PARAMS];
+    float *values[MAX_SWEEP_PARAMS];
+    long points;
+} sweep_spec;
+
+/* 解析"key=v1,v2,...;key=lo:hi:n"形式的扫描空间，key为硬件cfg中的数值字段名，
+   lo:hi:n表示从lo到hi(含)等间距的n个值 */
+void parse_sweep(char *s, sweep_spec *spec);
+void free_sweep(sweep_spec *spec);
+// 按硬件cfg的字段名设置硬件参数，不支持的字段返回0
+int set_hardware_field(asic *hardware, char *key, float value);
+// 按字段名读取硬件参数，is_int非0时返回该字段是否为整数
+float get_hardware_field(asic *hardware, char *key, int *is_int);
+/* 用threads个线程(0表示cpu核数)评估网络在扫描空间每个点上的代价，工作线程原子地领取连续的一段点，
+   结果经各自的缓冲写入out(0表示不写文件)并在线统计，最后报告延迟分布、最优的top个点和参数敏感度 */
+void sweep_report(asic *hardware, network *net, sweep_spec *spec, char *out, int threads, int top);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
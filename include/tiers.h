@@ -0,0 +1,33 @@
+#ifndef TIERS_H
+#define TIERS_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    OBJ_WEIGHTS, OBJ_KV_CACHE, OBJ_EXPERT, OBJ_TABLE, OBJ_ACTIVATIONS
+} OBJECT_KIND;
+
+// 放置到存储层级中的一块数据：一层的权重、kv cache、一个moe专家、一张embedding表或整个网络共用的激活区
+typedef struct placement_object {
+    OBJECT_KIND kind;
+    int layer;          //-1 for the activations every layer shares
+    int expert;
+    float size;         //bytes resident, for all blocks of the model
+    float traffic;      //bytes moved per inference
+    float requests;     //independent gathers among them
+    float share[MAX_TIERS];     //fraction placed in each tier
+} placement_object;
+
+char *get_object_string(OBJECT_KIND k);
+/* 把网络(块内的层重复net->blocks次，once=1的层只算一次)的权重、kv cache、moe专家、embedding表和激活区按每字节访存量从高到低
+   依次放入带宽从高到低的存储层级，放不下的部分放入下一级；报告各层级的占用、访存量和时间，
+   各数据的位置，以及按此放置的网络延迟与单一片外存储模型的对比 */
+void tiers_report(asic *hardware, network *net);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,17 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include "simulator.h"
+#include "engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 将事件引擎记录的时间线写成Chrome trace-event格式的json(可用chrome://tracing或Perfetto打开)，
+   每个alu和DMA各占一条轨道，另有一条按算子划分的轨道以及带宽、片上缓存占用两个计数器 */
+void write_trace(char *filename, timeline *t, network *net, asic *hardware);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,38 @@
+#ifndef TRAIN_H
+#define TRAIN_H
+#include "simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SGD, MOMENTUM, ADAM
+} OPTIMIZER;
+
+//what the backward pass keeps from the forward one
+typedef enum {
+    RECOMPUTE_NONE,         //every layer's input is stashed
+    RECOMPUTE_ATTENTION,    //attention probabilities are recomputed, the rest stashed
+    RECOMPUTE_CHECKPOINT    //only every sqrt(n)-th layer's input, segments run forward again
+} RECOMPUTE;
+
+typedef struct train_config {
+    OPTIMIZER optimizer;
+    RECOMPUTE recompute;
+} train_config;
+
+OPTIMIZER get_optimizer(char *s);
+char *get_optimizer_string(OPTIMIZER o);
+RECOMPUTE get_recompute(char *s);
+char *get_recompute_string(RECOMPUTE r);
+// 算子的参数个数(卷积核、全连接和rnn/lstm各门的权重、embedding表、batchnorm的gamma/beta)
+float layer_params(layer *l);
+/* 一个训练步的代价：前向、重计算、反向求输入梯度、反向求权重梯度和优化器更新(sgd/momentum/adam的状态读写)
+   各阶段的运算量、访存量和时间，报告步长时间、相对前向的访存倍数和峰值内存(权重、梯度、优化器状态、保存的激活) */
+void training_report(asic *hardware, network *net, train_config *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -14,6 +14,9 @@
 extern "C" {
 #endif
 
+// 单调时钟的当前时间(in s)
+double what_time_is_it_now();
+
 void *xmalloc(size_t size); //带报错的malloc
 void *xcalloc(size_t nmemb, size_t size); //带报错的calloc，分配并初始化内存空间
 void *xrealloc(void *ptr, size_t size); //带报错的ralloc，重新分配内存的size大小
@@ -64,6 +67,10 @@ LIB_API void free_ptrs(void **ptrs, int n);
 
 // 从文件流 fp 中读取一行文本(读到'\n'为止)，并返回一个动态分配的字符数组，存储该行文本的内容
 char *fgetl(FILE *fp);
+// 解析以逗号分隔的浮点数列表，最多max个，返回个数
+int parse_float_list(char *s, float *out, int max);
+// 同上，也接受"lo:hi:n"，表示从lo到hi(含)等间距的n个值
+int parse_range_list(char *s, float *out, int max);
 // 复制输入的字符串 s 并返回一个新的动态分配的字符串
 char *copy_string(char *s);
 // 没用上
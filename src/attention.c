@@ -0,0 +1,53 @@
+#include "attention.h"
+#include "cost.h"
+#include "utils.h"
+
+void attention_report(asic *hardware, network *net, float *lengths, int n) {
+  int i, k;
+  int layers = 0;
+  for (i = 0; i < net->n; ++i) layers += net->layers[i].type == ATTENTION;
+  printf("===========attention======================\n");
+  if (layers == 0) {
+    printf("No attention layers\n");
+    printf("===========attention======================\n\n\n");
+    return;
+  }
+  printf("Attention Layers       : %d\n", layers);
+  printf("On-chip Buffer         : %d KB\n\n", hardware->sram_size);
+  printf("%10s  %12s  %12s  %8s  %14s  %14s  %14s  %14s  %8s  %8s  %8s  %6s  %6s\n", "Length", "Naive(MB)",
+      "Tiled(MB)", "Saved(%)", "Naive Mem(us)", "Tiled Mem(us)", "Naive(us)", "Tiled(us)", "Speedup", "Naive",
+      "Tiled", "Block", "Passes");
+  for (k = 0; k < n; ++k) {
+    int length = (int)(lengths[k] + 0.5f);
+    float naive_mem = 0, tiled_mem = 0, naive_t = 0, tiled_t = 0;
+    float naive_alu = 0, naive_io = 0, tiled_alu = 0, tiled_io = 0;
+    int block = 0, passes = 0;
+    if (length < 1) continue;
+    for (i = 0; i < net->n; ++i) {
+      layer l = net->layers[i];
+      if (l.type != ATTENTION) continue;
+      //prefill attends over its own tokens, a decoding step over the cache
+      if (l.seq_len > 1 || l.kv_len <= 1) l.seq_len = length;
+      l.kv_len = length;
+      layer_impl impl = default_impl(hardware, &l);
+      impl.attention = ATTN_NAIVE;
+      layer_cost naive = cost_layer_impl(hardware, &l, &impl);
+      impl.attention = ATTN_FLASH;
+      layer_cost tiled = cost_layer_impl(hardware, &l, &impl);
+      naive_mem += naive.mem;
+      tiled_mem += tiled.mem;
+      naive_t += layer_latency(&naive);
+      tiled_t += layer_latency(&tiled);
+      naive_alu += naive.alu_perf;
+      naive_io += naive.mem_perf;
+      tiled_alu += tiled.alu_perf;
+      tiled_io += tiled.mem_perf;
+      if (!block) block = attention_block(hardware, &l, &passes);
+    }
+    printf("%10d  %12.3f  %12.3f  %8.2f  %14.5f  %14.5f  %14.5f  %14.5f  %8.3f  %8s  %8s  %6d  %6d\n", length,
+        naive_mem / (1024 * 1024), tiled_mem / (1024 * 1024), naive_mem > 0 ? 100 * (1 - tiled_mem / naive_mem) : 0,
+        naive_io, tiled_io, naive_t, tiled_t, tiled_t > 0 ? naive_t / tiled_t : 0, naive_alu > naive_io ? "compute" : "memory",
+        tiled_alu > tiled_io ? "compute" : "memory", block, passes);
+  }
+  printf("===========attention======================\n\n\n");
+}
@@ -0,0 +1,178 @@
+#include <float.h>
+
+#include "autotune.h"
+#include "cost.h"
+#include "network.h"
+#include "utils.h"
+
+static int has_weights(layer *l) {
+  return l->type == CONVOLUTIONAL || l->type == CONNECTED || l->type == DECONV ||
+         l->type == RNN || l->type == LSTM;
+}
+
+int layer_candidates(asic *hardware, layer *l, layer_impl *out) {
+  UNIT_TYPE units[2];
+  int taylor[2];
+  CONV_ALGO convs[NUM_CONV_ALGOS] = {CONV_DIRECT};
+  int tiles[4] = {0};
+  int nunits = 1, ntaylor = 1, nconvs = 1, ntiles = 1;
+  layer_impl def = default_impl(hardware, l);
+  int u, t, a, k;
+  int n = 0;
+
+  units[0] = def.unit;
+  if (l->type == CONVOLUTIONAL || l->type == CONNECTED || l->type == DECONV) {
+    units[0] = TENSOR_UNIT;
+    units[1] = VECTOR_UNIT;
+    nunits = 2;
+  }
+  taylor[0] = def.taylor;
+  if ((l->type == ACTIVE || l->type == LRN) && hardware->surpass_num > 0) {
+    taylor[0] = 0;
+    taylor[1] = 1;
+    ntaylor = 2;
+  }
+  //every algorithm the convolution's shape and the mac precision allow
+  if (l->type == CONVOLUTIONAL) {
+    nconvs = 0;
+    for (a = CONV_DIRECT; a < NUM_CONV_ALGOS; ++a) {
+      if (conv_algo_applies(l, (CONV_ALGO)a) && conv_algo_exact(hardware, (CONV_ALGO)a)) convs[nconvs++] = (CONV_ALGO)a;
+    }
+  }
+  //weight tiles of 1/2 down to 1/16 of the buffer, the rest holds the input
+  if (has_weights(l)) {
+    ntiles = 0;
+    for (k = 2; k <= 16 && hardware->sram_size / k >= 1; k *= 2) tiles[ntiles++] = hardware->sram_size / k;
+    if (ntiles == 0) tiles[ntiles++] = 1;
+  }
+
+  for (u = 0; u < nunits; ++u) {
+    for (t = 0; t < ntaylor; ++t) {
+      for (a = 0; a < nconvs; ++a) {
+        for (k = 0; k < ntiles && n < MAX_IMPLS; ++k) {
+          layer_impl impl = def;
+          impl.unit = units[u];
+          impl.taylor = taylor[t];
+          impl.conv = convs[a];
+          impl.tile = tiles[k];
+          out[n++] = impl;
+        }
+      }
+    }
+  }
+  //attention is tried both naive and tiled
+  if (l->type == ATTENTION) {
+    int m = n;
+    for (k = 0; k < m && n < MAX_IMPLS; ++k) {
+      out[n] = out[k];
+      out[n++].attention = out[k].attention == ATTN_FLASH ? ATTN_NAIVE : ATTN_FLASH;
+    }
+  }
+  return n;
+}
+
+//a route reads only the layer it refers to, a shortcut the layer before it and the one it refers to
+static int reads_layer(network *net, int j, int i) {
+  layer *l = &net->layers[j];
+  if ((l->type == ROUTE || l->type == SHORTCUT) && l->index == i) return 1;
+  return l->type != ROUTE && j == i + 1;
+}
+
+int can_fuse(asic *hardware, network *net, int i) {
+  int j;
+  if (i + 1 >= net->n || !reads_layer(net, i + 1, i)) return 0;
+  //an output another layer reads later has to go offchip anyway
+  for (j = i + 2; j < net->n; ++j) {
+    if (reads_layer(net, j, i)) return 0;
+  }
+  layer *next = &net->layers[i + 1];
+  if (next->type == ACTIVE || next->type == RELU) return 1;
+  layer_cost c = cost_layer(hardware, &net->layers[i]);
+  return c.mem_out <= hardware->sram_size * 1024.0 / 2;
+}
+
+static char *impl_string(layer *l, layer_impl *impl) {
+  if (l->type == CONVOLUTIONAL) return get_conv_string(impl->conv);
+  if (l->type == ACTIVE || l->type == LRN) return impl->taylor ? "taylor" : "surpass";
+  if (l->type == ATTENTION) return impl->attention == ATTN_FLASH ? "flash" : "naive";
+  return "-";
+}
+
+//the default plan is the mapping of the main report, which fuses nothing
+static float default_plan(asic *hardware, network *net) {
+  float total = 0;
+  int i;
+  for (i = 0; i < net->n; ++i) {
+    layer_cost c = cost_layer(hardware, &net->layers[i]);
+    total += layer_repeats(net, &net->layers[i]) * layer_latency(&c);
+  }
+  return total;
+}
+
+void autotune_report(asic *hardware, network *net) {
+  int n = net->n;
+  //best[2*i + s]: lowest latency of layers before i with layer i's input on chip (s = 1) or not
+  float *best = (float*)xcalloc(2 * (n + 1), sizeof(float));
+  layer_impl *pick = (layer_impl*)xcalloc(2 * (n + 1), sizeof(layer_impl));
+  int *from = (int*)xcalloc(2 * (n + 1), sizeof(int));
+  layer_impl cand[MAX_IMPLS];
+  int i, s, k, o;
+
+  best[0] = 0;
+  best[1] = FLT_MAX;
+  for (i = 0; i < n; ++i) {
+    layer *l = &net->layers[i];
+    int m = layer_candidates(hardware, l, cand);
+    int fuse = can_fuse(hardware, net, i);
+    float r = layer_repeats(net, l);
+    best[2*(i+1)] = best[2*(i+1) + 1] = FLT_MAX;
+    for (s = 0; s < 2; ++s) {
+      if (best[2*i + s] == FLT_MAX) continue;
+      for (k = 0; k < m; ++k) {
+        for (o = 0; o <= fuse; ++o) {
+          layer_impl impl = cand[k];
+          impl.in_onchip = s;
+          impl.out_onchip = o;
+          layer_cost c = cost_layer_impl(hardware, l, &impl);
+          float t = best[2*i + s] + r * layer_latency(&c);
+          if (t < best[2*(i+1) + o]) {
+            best[2*(i+1) + o] = t;
+            pick[2*(i+1) + o] = impl;
+            from[2*(i+1) + o] = s;
+          }
+        }
+      }
+    }
+  }
+
+  //walk the choices back from the last layer, whose output always goes offchip
+  layer_impl *plan = (layer_impl*)xcalloc(n > 0 ? n : 1, sizeof(layer_impl));
+  s = 0;
+  for (i = n; i > 0; --i) {
+    plan[i-1] = pick[2*i + s];
+    s = from[2*i + s];
+  }
+
+  float def = default_plan(hardware, net);
+  printf("===========auto-tuning====================\n");
+  if (net->blocks > 1) {
+    printf("Blocks                 : %d (layer rows are one block, plan latencies the whole model)\n", net->blocks);
+  }
+  printf("Layer  Type             Unit      Impl       Tile(KB)  Fused   Compute(us)    Memory(us)   Latency(us)\n");
+  for (i = 0; i < n; ++i) {
+    layer *l = &net->layers[i];
+    layer_cost c = cost_layer_impl(hardware, l, &plan[i]);
+    printf("%5d  %-15s  %-8s  %-9s  %8d  %-5s  %12.5f  %12.5f  %12.5f\n", i, get_layer_string(l->type),
+        get_unit_string(c.unit), impl_string(l, &plan[i]), plan[i].tile, plan[i].out_onchip ? "->" : "",
+        c.alu_perf, c.mem_perf, layer_latency(&c));
+  }
+  printf("Default Plan Latency   : %.5f us\n", def);
+  printf("Tuned Plan Latency     : %.5f us\n", best[2*n]);
+  printf("Speedup                : %.5fx\n", best[2*n] > 0 ? def / best[2*n] : 1);
+  printf("===========auto-tuning====================\n\n\n");
+
+  free(plan);
+  free(best);
+  free(pick);
+  free(from);
+}
@@ -0,0 +1,315 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calibrate.h"
+#include "cost.h"
+#include "mapping.h"
+#include "network.h"
+#include "parser.h"
+#include "utils.h"
+
+typedef struct sample {
+    float measured;
+    int model;                  //network in the cache
+    int index;                  //layer, -1 for the whole network
+} sample;
+
+typedef struct model_cache {
+    char *cfgfile;
+    network net;
+} model_cache;
+
+//efficiencies being fitted(in %), either the global ones or bandwidth plus one per layer type
+typedef struct fit {
+    int k;
+    int per_type;
+    char *keys[MAX_PARAMS];
+    float eff[MAX_PARAMS];
+    int types[MAX_PARAMS];      //layer type of a per type parameter
+} fit;
+
+static void apply_fit(fit *f, asic *hardware) {
+  int j;
+  if (f->per_type) {
+    hardware->ave_bw_eff = f->eff[0];
+    for (j = 1; j < f->k; ++j) hardware->type_eff[f->types[j]] = f->eff[j];
+  } else {
+    hardware->ave_alu_eff = f->eff[0];
+    hardware->ave_bw_eff = f->eff[1];
+    hardware->surpass_eff = f->eff[2];
+  }
+}
+
+static float sample_latency(asic *hardware, layer *l) {
+  layer_cost c = cost_layer(hardware, l);
+  return layer_latency(&c);
+}
+
+//relative error of every sample with the parameters of f, returns the sum of squares
+static double sample_errors(fit *f, asic *base, model_cache *cache, sample *samples, int n, float *err) {
+  asic a = *base;
+  double sq = 0;
+  int i;
+  apply_fit(f, &a);
+  for (i = 0; i < n; ++i) {
+    network *net = &cache[samples[i].model].net;
+    float t = samples[i].index >= 0 ? sample_latency(&a, &net->layers[samples[i].index])
+                                    : cost_network(&a, net).peak_perf;
+    err[i] = (t - samples[i].measured) / samples[i].measured;
+    sq += (double)err[i] * err[i];
+  }
+  return sq;
+}
+
+static int find_model(model_cache **cache, int *n, int *size, char *cfgfile) {
+  int i;
+  for (i = 0; i < *n; ++i) {
+    if (strcmp((*cache)[i].cfgfile, cfgfile) == 0) return i;
+  }
+  if (*n == *size) {
+    *size = *size ? 2 * *size : 16;
+    *cache = (model_cache*)xrealloc(*cache, *size * sizeof(model_cache));
+  }
+  (*cache)[*n].cfgfile = copy_string(cfgfile);
+  (*cache)[*n].net = parse_network_cfg(cfgfile);
+  return (*n)++;
+}
+
+//reads "cfg,layer,latency_us" rows, networks are parsed once however many rows use them
+static sample *read_samples(char *filename, model_cache **cache, int *ncache, int *n, int *nets) {
+  FILE *file = fopen(filename, "r");
+  if (file == 0) file_error(filename);
+  int cache_size = 0;
+  int size = 1024;
+  sample *samples = (sample*)xcalloc(size, sizeof(sample));
+  char *line;
+  int nu = 0;
+  *n = 0;
+  *nets = 0;
+  while ((line = fgetl(file)) != 0) {
+    ++nu;
+    strip(line);
+    char cfgfile[256], index[32];
+    float measured;
+    if (line[0] == '#' || line[0] == '\0' ||
+        sscanf(line, "%255[^,],%31[^,],%f", cfgfile, index, &measured) != 3) {
+      //a header line isn't worth a warning
+      if (nu > 1 && line[0] != '#' && line[0] != '\0') fprintf(stderr, "Calibration file error line %d, couldn't parse: %s\n", nu, line);
+      free(line);
+      continue;
+    }
+    free(line);
+    if (measured <= 0) continue;
+    int model = find_model(cache, ncache, &cache_size, cfgfile);
+    int i = strcmp(index, "all") == 0 ? -1 : atoi(index);
+    if (i >= (*cache)[model].net.n) {
+      fprintf(stderr, "Calibration file line %d: %s has no layer %d\n", nu, cfgfile, i);
+      continue;
+    }
+    if (*n == size) {
+      size *= 2;
+      samples = (sample*)xrealloc(samples, size * sizeof(sample));
+    }
+    sample *s = &samples[(*n)++];
+    s->measured = measured;
+    s->model = model;
+    s->index = i < 0 ? -1 : i;
+    if (i < 0) ++*nets;
+  }
+  fclose(file);
+  return samples;
+}
+
+//gaussian elimination with partial pivoting on the k x k normal equations
+static void solve(double *a, double *b, int k) {
+  int i, j, r;
+  for (i = 0; i < k; ++i) {
+    int p = i;
+    for (r = i + 1; r < k; ++r) if (fabs(a[r*k + i]) > fabs(a[p*k + i])) p = r;
+    if (p != i) {
+      for (j = 0; j < k; ++j) {
+        double t = a[i*k + j]; a[i*k + j] = a[p*k + j]; a[p*k + j] = t;
+      }
+      double t = b[i]; b[i] = b[p]; b[p] = t;
+    }
+    if (a[i*k + i] == 0) continue;
+    for (r = i + 1; r < k; ++r) {
+      double m = a[r*k + i] / a[i*k + i];
+      for (j = i; j < k; ++j) a[r*k + j] -= m * a[i*k + j];
+      b[r] -= m * b[i];
+    }
+  }
+  for (i = k - 1; i >= 0; --i) {
+    for (j = i + 1; j < k; ++j) b[i] -= a[i*k + j] * b[j];
+    b[i] = a[i*k + i] != 0 ? b[i] / a[i*k + i] : 0;
+  }
+}
+
+/* levenberg-marquardt on the relative errors with a forward difference jacobian, which
+   goes through the full cost model so lrn's dependence on surpass_efficiency, the dram
+   model and the compute/memory bottleneck switch are all fitted as they are costed;
+   parameters no sample depends on get a zero column and stay where they are */
+static int calibrate(fit *f, asic *base, model_cache *cache, sample *samples, int n) {
+  int k = f->k;
+  float *err = (float*)xcalloc(n, sizeof(float));
+  float *trial = (float*)xcalloc(n, sizeof(float));
+  float *jac = (float*)xcalloc((size_t)n * k, sizeof(float));
+  double cost = sample_errors(f, base, cache, samples, n, err);
+  double lambda = 1e-3;
+  int iter, i, j, r;
+  for (iter = 0; iter < 100; ++iter) {
+    for (j = 0; j < k; ++j) {
+      fit g = *f;
+      float h = f->eff[j] * 1e-3;
+      g.eff[j] += h;
+      sample_errors(&g, base, cache, samples, n, trial);
+      for (i = 0; i < n; ++i) jac[(size_t)i*k + j] = (trial[i] - err[i]) / h;
+    }
+    double jtj[MAX_PARAMS * MAX_PARAMS] = {0};
+    double jtr[MAX_PARAMS] = {0};
+    for (i = 0; i < n; ++i) {
+      float *row = &jac[(size_t)i*k];
+      for (j = 0; j < k; ++j) {
+        if (row[j] == 0) continue;
+        for (r = 0; r < k; ++r) jtj[j*k + r] += (double)row[j] * row[r];
+        jtr[j] -= (double)row[j] * err[i];
+      }
+    }
+
+    int improved = 0;
+    while (lambda < 1e10) {
+      double a[MAX_PARAMS * MAX_PARAMS];
+      double step[MAX_PARAMS];
+      memcpy(a, jtj, sizeof(a));
+      memcpy(step, jtr, sizeof(step));
+      for (j = 0; j < k; ++j) a[j*k + j] += lambda * (jtj[j*k + j] > 0 ? jtj[j*k + j] : 1);
+      solve(a, step, k);
+      fit g = *f;
+      //efficiencies stay within 1%..100%
+      for (j = 0; j < k; ++j) {
+        g.eff[j] += step[j];
+        if (g.eff[j] < 1) g.eff[j] = 1;
+        if (g.eff[j] > 100) g.eff[j] = 100;
+      }
+      double c = sample_errors(&g, base, cache, samples, n, trial);
+      if (c < cost) {
+        improved = cost - c > 1e-9 * cost;
+        *f = g;
+        cost = c;
+        memcpy(err, trial, n * sizeof(float));
+        lambda /= 10;
+        break;
+      }
+      lambda *= 10;
+    }
+    if (!improved) break;
+  }
+  free(err);
+  free(trial);
+  free(jac);
+  return iter + 1;
+}
+
+static void residuals(fit *f, asic *base, model_cache *cache, sample *samples, int n,
+    float *rms, float *mean, float *max) {
+  float *err = (float*)xcalloc(n, sizeof(float));
+  double ab = 0;
+  int i;
+  *rms = 100 * sqrt(sample_errors(f, base, cache, samples, n, err) / n);
+  *max = 0;
+  for (i = 0; i < n; ++i) {
+    ab += fabs(err[i]);
+    if (100 * fabs(err[i]) > *max) *max = 100 * fabs(err[i]);
+  }
+  *mean = 100 * ab / n;
+  free(err);
+}
+
+//marks the layer types a sample covers with the efficiency their unit runs at
+static void sample_types(asic *hardware, network *net, int index, float *eff) {
+  int j;
+  for (j = 0; j < net->n; ++j) {
+    if (index >= 0 && j != index) continue;
+    layer *l = &net->layers[j];
+    eff[l->type] = unit_efficiency(hardware, cost_layer(hardware, l).unit);
+  }
+}
+
+void calibrate_report(asic *hardware, char *filename) {
+  asic base = *hardware;
+  model_cache *cache = 0;
+  int ncache = 0;
+  int n, nets, i, t;
+  //per type efficiencies already in the cfg are fitted again from the unit defaults
+  for (t = 0; t <= BLANK; ++t) base.type_eff[t] = 0;
+
+  double t0 = what_time_is_it_now();
+  sample *samples = read_samples(filename, &cache, &ncache, &n, &nets);
+  if (n == 0) {
+    fprintf(stderr, "No calibration samples in %s\n", filename);
+    free(samples);
+    free(cache);
+    return;
+  }
+
+  fit global = {0};
+  global.k = 3;
+  global.keys[0] = "average_alu_efficiency";
+  global.keys[1] = "average_bandwidth_efficiency";
+  global.keys[2] = "surpass_efficiency";
+  global.eff[0] = base.ave_alu_eff;
+  global.eff[1] = base.ave_bw_eff;
+  global.eff[2] = base.surpass_eff;
+  fit before = global;
+
+  //one alu efficiency per layer type that appears in the samples, starting from its unit's
+  float present[BLANK + 1] = {0};
+  for (i = 0; i < n; ++i) sample_types(&base, &cache[samples[i].model].net, samples[i].index, present);
+  fit typed = {0};
+  typed.per_type = 1;
+  typed.k = 1;
+  typed.keys[0] = "average_bandwidth_efficiency";
+  typed.eff[0] = base.ave_bw_eff;
+  for (t = 0; t <= BLANK && typed.k < MAX_PARAMS; ++t) {
+    if (present[t] <= 0) continue;
+    typed.types[typed.k] = t;
+    typed.keys[typed.k] = get_layer_string((LAYER_TYPE)t);
+    typed.eff[typed.k] = present[t];
+    ++typed.k;
+  }
+  double t1 = what_time_is_it_now();
+
+  float rms[3], mean[3], max[3];
+  residuals(&before, &base, cache, samples, n, &rms[0], &mean[0], &max[0]);
+  int global_iters = calibrate(&global, &base, cache, samples, n);
+  residuals(&global, &base, cache, samples, n, &rms[1], &mean[1], &max[1]);
+  int typed_iters = calibrate(&typed, &base, cache, samples, n);
+  residuals(&typed, &base, cache, samples, n, &rms[2], &mean[2], &max[2]);
+  double t2 = what_time_is_it_now();
+
+  printf("===========calibration====================\n");
+  printf("Samples                : %d (%d layers, %d networks) from %s\n", n, n - nets, nets, filename);
+  printf("Loading Time           : %.3f ms\n", (t1 - t0) * 1000);
+  printf("Fitting Time           : %.3f ms (%d + %d iterations)\n", (t2 - t1) * 1000, global_iters, typed_iters);
+  printf("                           Before    Global Fit  Per-type Fit\n");
+  printf("RMS Error(%%)           : %10.3f  %12.3f  %12.3f\n", rms[0], rms[1], rms[2]);
+  printf("Mean Abs Error(%%)      : %10.3f  %12.3f  %12.3f\n", mean[0], mean[1], mean[2]);
+  printf("Max Abs Error(%%)       : %10.3f  %12.3f  %12.3f\n", max[0], max[1], max[2]);
+  printf("\nGlobal fit:\n");
+  for (i = 0; i < global.k; ++i) {
+    if (i == 2 && hardware->surpass_num == 0) continue;
+    printf("%s = %.3f\n", global.keys[i], global.eff[i]);
+  }
+  printf("\nPer-type fit:\n");
+  printf("%s = %.3f\n", typed.keys[0], typed.eff[0]);
+  for (i = 1; i < typed.k; ++i) printf("%s_efficiency = %.3f\n", typed.keys[i], typed.eff[i]);
+  printf("===========calibration====================\n\n\n");
+
+  for (i = 0; i < ncache; ++i) {
+    free(cache[i].cfgfile);
+    free_network(cache[i].net);
+  }
+  free(cache);
+  free(samples);
+}
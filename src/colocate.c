@@ -0,0 +1,175 @@
+#include <math.h>
+#include <string.h>
+
+#include "colocate.h"
+#include "cost.h"
+#include "mapping.h"
+#include "utils.h"
+
+static int scale_units(int num, float share) {
+  int k = (int)(num * share + 0.5);
+  return k > 0 ? k : 1;
+}
+
+asic partition_asic(asic *hardware, float compute, float bandwidth) {
+  asic a = *hardware;
+  //a spatial slice of the array keeps its rows and gets a share of the columns
+  if (has_mac_array(hardware)) {
+    a.mac_cols = scale_units(hardware->mac_cols, compute);
+    a.mac_num = a.mac_rows * a.mac_cols;
+  } else {
+    a.mac_num = scale_units(hardware->mac_num, compute);
+  }
+  a.vec_num = scale_units(hardware->vec_num, compute);
+  if (hardware->surpass_num > 0) a.surpass_num = scale_units(hardware->surpass_num, compute);
+  a.off_bw = hardware->off_bw * bandwidth;
+  a.pwr = hardware->pwr * compute;
+  a.static_pwr = hardware->static_pwr * compute;
+  return a;
+}
+
+static float model_latency(asic *hardware, network *net) {
+  return cost_network(hardware, net).peak_perf;
+}
+
+//a split is feasible when every model meets its slo, otherwise the least bad one is kept
+typedef struct split {
+    int compute[MAX_MODELS];    //in units of 1/step, or slots per round when time slicing
+    int bandwidth[MAX_MODELS];
+    float latency[MAX_MODELS];
+    float qps[MAX_MODELS];
+    float throughput;
+    float violation;            //worst latency / slo
+} split;
+
+typedef struct search {
+    int n;
+    int step;
+    float *slo;
+    float *table;               //latency of model i with k compute and j bandwidth units
+    split cur;
+    split best;
+    int found;
+} search;
+
+static float *spatial_table(search *s, int i, int k, int j) {
+  return &s->table[(i * (s->step + 1) + k) * (s->step + 1) + j];
+}
+
+static void evaluate(search *s) {
+  split *c = &s->cur;
+  int i;
+  c->throughput = 0;
+  c->violation = 0;
+  for (i = 0; i < s->n; ++i) {
+    c->throughput += c->qps[i];
+    if (s->slo[i] > 0 && c->latency[i] / s->slo[i] > c->violation) c->violation = c->latency[i] / s->slo[i];
+  }
+  int feasible = c->violation <= 1;
+  if (feasible && (!s->found || c->throughput > s->best.throughput)) {
+    s->best = *c;
+    s->found = 1;
+  } else if (!s->found && (s->best.violation == 0 || c->violation < s->best.violation)) {
+    s->best = *c;
+  }
+}
+
+//every model gets at least one unit of compute and bandwidth, all units are handed out
+static void search_spatial(search *s, int i, int compute, int bandwidth) {
+  int left = s->n - i - 1;
+  int k, j;
+  for (k = 1; k <= compute - left; ++k) {
+    for (j = 1; j <= bandwidth - left; ++j) {
+      if (left == 0 && (k != compute || j != bandwidth)) continue;
+      s->cur.compute[i] = k;
+      s->cur.bandwidth[i] = j;
+      s->cur.latency[i] = *spatial_table(s, i, k, j);
+      s->cur.qps[i] = 1e6 / s->cur.latency[i];
+      if (left == 0) evaluate(s);
+      else search_spatial(s, i + 1, compute - k, bandwidth - j);
+    }
+  }
+}
+
+//round robin over the whole asic, model i runs slots[i] inferences back to back per round;
+//a request waits for the other models' slots at worst, then runs
+static void search_time(search *s, float *alone, int i) {
+  int r;
+  for (r = 1; r <= MAX_SLOTS; ++r) {
+    s->cur.compute[i] = r;
+    if (i + 1 < s->n) {
+      search_time(s, alone, i + 1);
+      continue;
+    }
+    float round = 0;
+    int m;
+    for (m = 0; m < s->n; ++m) round += s->cur.compute[m] * alone[m];
+    for (m = 0; m < s->n; ++m) {
+      s->cur.latency[m] = round - (s->cur.compute[m] - 1) * alone[m];
+      s->cur.qps[m] = s->cur.compute[m] * 1e6 / round;
+    }
+    evaluate(s);
+  }
+}
+
+static void print_split(search *s, char **names, int spatial) {
+  int i;
+  if (!s->found) printf("No split meets every SLO, closest one (%.3fx over):\n", s->best.violation);
+  printf(spatial ? "Model                 Compute(%%)  BW(%%)  Latency(us)       SLO(us)           QPS\n"
+                 : "Model                 Slots  Latency(us)       SLO(us)           QPS\n");
+  for (i = 0; i < s->n; ++i) {
+    char *name = strrchr(names[i], '/') ? strrchr(names[i], '/') + 1 : names[i];
+    if (spatial) {
+      printf("%-20s  %10.1f  %5.1f  %11.5f  %12.5f  %12.5f\n", name, 100.0 * s->best.compute[i] / s->step,
+          100.0 * s->best.bandwidth[i] / s->step, s->best.latency[i], s->slo[i], s->best.qps[i]);
+    } else {
+      printf("%-20s  %5d  %11.5f  %12.5f  %12.5f\n", name, s->best.compute[i],
+          s->best.latency[i], s->slo[i], s->best.qps[i]);
+    }
+  }
+  printf("Aggregate Throughput   : %.5f inferences/s\n", s->best.throughput);
+}
+
+void colocate_report(asic *hardware, network *nets, char **names, int n, float *slo, int step) {
+  search s = {0};
+  float alone[MAX_MODELS];
+  int i, k, j;
+  if (n > MAX_MODELS) {
+    fprintf(stderr, "Only %d models can be co-located, using the first %d\n", MAX_MODELS, MAX_MODELS);
+    n = MAX_MODELS;
+  }
+  if (step < n) step = n;
+  s.n = n;
+  s.step = step;
+  s.slo = slo;
+
+  printf("===========co-location====================\n");
+  printf("Model                 Alone(us)       SLO(us)\n");
+  for (i = 0; i < n; ++i) {
+    char *name = strrchr(names[i], '/') ? strrchr(names[i], '/') + 1 : names[i];
+    alone[i] = model_latency(hardware, &nets[i]);
+    printf("%-20s  %9.5f  %12.5f\n", name, alone[i], slo[i]);
+  }
+
+  //each model's latency on every slice is evaluated once, the search only looks them up
+  s.table = (float*)xcalloc(n * (step + 1) * (step + 1), sizeof(float));
+  for (i = 0; i < n; ++i) {
+    for (k = 1; k <= step; ++k) {
+      for (j = 1; j <= step; ++j) {
+        asic a = partition_asic(hardware, (float)k / step, (float)j / step);
+        *spatial_table(&s, i, k, j) = model_latency(&a, &nets[i]);
+      }
+    }
+  }
+  printf("\nSpatial partitioning (%d steps):\n", step);
+  search_spatial(&s, 0, step, step);
+  print_split(&s, names, 1);
+
+  s.found = 0;
+  memset(&s.best, 0, sizeof(split));
+  printf("\nTime slicing (up to %d slots per round):\n", MAX_SLOTS);
+  search_time(&s, alone, 0);
+  print_split(&s, names, 0);
+  printf("===========co-location====================\n\n\n");
+  free(s.table);
+}
@@ -0,0 +1,93 @@
+#include "conv.h"
+#include "cost.h"
+#include "utils.h"
+
+//the alu or the memory that bounds a layer; transforms count against the vector alu
+static char *bound_string(layer_cost *c) {
+  float main = c->alu_perf - c->aux_perf;
+  if (c->mem_perf >= c->alu_perf) return "memory";
+  if (c->unit == TENSOR_UNIT && c->aux_perf > main) return "vector";
+  return get_unit_string(c->unit);
+}
+
+//time of each unit summed over the network
+typedef struct conv_totals {
+    float tensor;
+    float vector;
+    float alu;
+    float mem;
+    float ops;
+} conv_totals;
+
+static void add_totals(conv_totals *t, layer_cost *c) {
+  t->tensor += c->unit == TENSOR_UNIT ? c->alu_perf - c->aux_perf : 0;
+  t->vector += c->unit == TENSOR_UNIT ? c->aux_perf : c->alu_perf;
+  t->alu += c->alu_perf;
+  t->mem += c->mem_perf;
+  t->ops += c->ops;
+}
+
+static void print_totals(char *name, conv_totals *t) {
+  float peak = t->alu > t->mem ? t->alu : t->mem;
+  char *bound = t->mem >= t->alu ? "memory" : t->vector > t->tensor ? "vector" : "tensor";
+  printf("%-10s  %10.3f  %12.5f  %12.5f  %12.5f  %12.5f  %8s\n", name, t->ops / 1e9, t->tensor, t->vector, t->mem,
+      peak, bound);
+}
+
+void conv_report(asic *hardware, network *net) {
+  int i, a;
+  int convs = 0;
+  for (i = 0; i < net->n; ++i) convs += net->layers[i].type == CONVOLUTIONAL;
+  printf("===========convolution algorithms=========\n");
+  if (convs == 0) {
+    printf("No convolutional layers\n");
+    printf("===========convolution algorithms=========\n\n\n");
+    return;
+  }
+  printf("Convolutional Layers   : %d\n", convs);
+  printf("MAC Precision          : %s", hardware->mac_dtype == 2 ? "fp32" : "half");
+  if (!conv_algo_exact(hardware, CONV_WINOGRAD4)) printf(" (winograd4 left out of auto)");
+  printf("\n\n");
+
+  //every layer with every algorithm it can run, the one auto picks marked
+  conv_totals totals[NUM_CONV_ALGOS] = {{0}}, tuned = {0}, cfg = {0};
+  printf("%5s  %7s  %-10s  %10s  %12s  %12s  %12s  %12s  %8s\n", "Layer", "Kernel", "Algo", "GOPs", "Tensor(us)",
+      "Vector(us)", "Memory(us)", "Latency(us)", "Bound");
+  for (i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if (l->type != CONVOLUTIONAL) {
+      //the rest of the network is the same under every algorithm
+      layer_cost c = cost_layer(hardware, l);
+      for (a = CONV_DIRECT; a < NUM_CONV_ALGOS; ++a) add_totals(&totals[a], &c);
+      add_totals(&tuned, &c);
+      add_totals(&cfg, &c);
+      continue;
+    }
+    layer_impl impl = default_impl(hardware, l);
+    layer_cost c = cost_layer_impl(hardware, l, &impl);
+    add_totals(&cfg, &c);
+    impl.unit = TENSOR_UNIT;
+    CONV_ALGO pick = fastest_conv(hardware, l, impl);
+    char kernel[16];
+    sprintf(kernel, "%dx%d/%d", l->size, l->size, l->stride_x);
+    for (a = CONV_DIRECT; a < NUM_CONV_ALGOS; ++a) {
+      layer_impl alt = impl;
+      alt.conv = conv_algo_applies(l, (CONV_ALGO)a) ? (CONV_ALGO)a : CONV_DIRECT;
+      layer_cost ac = cost_layer_impl(hardware, l, &alt);
+      add_totals(&totals[a], &ac);
+      if (a == pick) add_totals(&tuned, &ac);
+      if (alt.conv != a) continue;
+      printf("%5d  %7s  %-10s  %10.3f  %12.5f  %12.5f  %12.5f  %12.5f  %8s%s%s\n", i, a == CONV_DIRECT ? kernel : "",
+          get_conv_string((CONV_ALGO)a), ac.ops / 1e9, ac.alu_perf - ac.aux_perf, ac.aux_perf, ac.mem_perf,
+          layer_latency(&ac), bound_string(&ac), a == pick ? "  *" : "", conv_algo_exact(hardware, (CONV_ALGO)a) ? "" : "  inexact");
+    }
+  }
+
+  //the whole network, convolutions falling back to direct where an algorithm doesn't apply
+  printf("\n%-10s  %10s  %12s  %12s  %12s  %12s  %8s\n", "Network", "GOPs", "Tensor(us)", "Vector(us)", "Memory(us)",
+      "Latency(us)", "Bound");
+  print_totals("cfg", &cfg);
+  for (a = CONV_DIRECT; a < NUM_CONV_ALGOS; ++a) print_totals(get_conv_string((CONV_ALGO)a), &totals[a]);
+  print_totals("auto", &tuned);
+  printf("===========convolution algorithms=========\n\n\n");
+}
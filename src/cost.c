@@ -0,0 +1,679 @@
+#include <math.h>
+#include <string.h>
+
+#include "cost.h"
+#include "mapping.h"
+#include "dram.h"
+#include "energy.h"
+#include "profile.h"
+#include "network.h"
+
+int dtype_size(int dtype) {
+  return dtype == 2 ? 4 : 2;
+}
+
+char *get_unit_string(UNIT_TYPE unit) {
+  switch(unit) {
+    case TENSOR_UNIT:
+      return "tensor";
+    case VECTOR_UNIT:
+      return "vector";
+    case SURPASS_UNIT:
+      return "surpass";
+  }
+  return "none";
+}
+
+char *get_conv_string(CONV_ALGO a) {
+  switch(a) {
+    case CONV_AUTO:
+      return "auto";
+    case CONV_DIRECT:
+      return "direct";
+    case CONV_IM2COL:
+      return "im2col";
+    case CONV_WINOGRAD2:
+      return "winograd2";
+    case CONV_WINOGRAD4:
+      return "winograd4";
+    case CONV_FFT:
+      return "fft";
+    default:
+      break;
+  }
+  return "none";
+}
+
+CONV_ALGO get_conv_algo(char *s) {
+  int a;
+  for (a = CONV_AUTO; a < NUM_CONV_ALGOS; ++a) {
+    if (strcmp(s, get_conv_string((CONV_ALGO)a)) == 0) return (CONV_ALGO)a;
+  }
+  fprintf(stderr, "Couldn't find convolution algorithm %s, going with direct\n", s);
+  return CONV_DIRECT;
+}
+
+int conv_algo_applies(layer *l, CONV_ALGO a) {
+  int groups = l->groups > 0 ? l->groups : 1;
+  int unit_stride = l->stride_x <= 1 && l->stride_y <= 1;
+  if (a == CONV_WINOGRAD2 || a == CONV_WINOGRAD4) return l->size == 3 && unit_stride && groups == 1;
+  if (a == CONV_FFT) return l->size > 1 && unit_stride && groups == 1;
+  return a == CONV_DIRECT || a == CONV_IM2COL;
+}
+
+int conv_algo_exact(asic *hardware, CONV_ALGO a) {
+  return a != CONV_WINOGRAD4 || hardware->mac_dtype == 2;
+}
+
+float pipe_efficiency(asic *hardware, UNIT_TYPE unit) {
+  //问题在于这样的评估方式是否合理，直接用1/(阻塞排数+1)来表示流水效率
+  if (unit == TENSOR_UNIT) {
+    return hardware->mac_pipeline == 1 ? 1 : 1.0/(hardware->mac_stall_cycle + 1);
+  } else if (unit == VECTOR_UNIT) {
+    return hardware->vec_pipeline == 1 ? 1 : 1.0/(hardware->vec_stall_cycle + 1);
+  }
+  return 1;
+}
+
+float alu_time(asic *hardware, UNIT_TYPE unit, float ops, float eff) {
+  int num = hardware->mac_num;
+  if (unit == VECTOR_UNIT) num = hardware->vec_num;
+  else if (unit == SURPASS_UNIT) num = hardware->surpass_num;
+  return ((((ops / num)) / hardware->freq) / (1000)) / eff;
+}
+
+float mem_time(asic *hardware, float mem, float eff) {
+  return (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / eff;// + hardware->latency;
+}
+
+float unit_efficiency(asic *hardware, UNIT_TYPE unit) {
+  if (unit == SURPASS_UNIT) return hardware->surpass_eff;
+  if (unit == TENSOR_UNIT && has_mac_array(hardware)) return 100;
+  return hardware->ave_alu_eff;
+}
+
+//vector layers share the global average alu efficiency
+static float vector_eff(asic *hardware) {
+  return (hardware->ave_alu_eff/100) * pipe_efficiency(hardware, VECTOR_UNIT);
+}
+
+//fully connected gemm, returns its compute time for one sample of the batch
+static float connected_perf(asic *hardware, layer *l, UNIT_TYPE unit, float *ops) {
+  float o = 2.0 * l->inputs * l->outputs;
+  *ops += o;
+  if (unit == VECTOR_UNIT) {
+    return alu_time(hardware, VECTOR_UNIT, o, vector_eff(hardware));
+  }
+  int m = (l->batch > 0 ? l->batch : 1) * (l->seq_len > 0 ? l->seq_len : 1);
+  float util = gemm_utilisation(hardware, m, l->outputs, l->inputs);
+  return alu_time(hardware, TENSOR_UNIT, o, util * pipe_efficiency(hardware, TENSOR_UNIT));
+}
+
+float recurrent_weight_bytes(asic *hardware, layer *l) {
+  float bytes = 0;
+  int mac_dtype = dtype_size(hardware->mac_dtype);
+  if (l->type == RNN) {
+    bytes = (float)l->self_layer->inputs * l->self_layer->outputs;
+  } else if (l->type == LSTM) {
+    bytes = (float)l->wf->inputs * l->wf->outputs + (float)l->wi->inputs * l->wi->outputs
+          + (float)l->wg->inputs * l->wg->outputs + (float)l->wo->inputs * l->wo->outputs;
+  }
+  return bytes * mac_dtype;
+}
+
+float resident_weight_bytes(asic *hardware, layer *l) {
+  //two tiles stay free to stream inputs and outputs through
+  float budget = (hardware->sram_size - 2.0 * hardware->tile_size) * 1024;
+  float bytes = recurrent_weight_bytes(hardware, l);
+  if (budget < 0) budget = 0;
+  return bytes < budget ? bytes : budget;
+}
+
+float attention_span(layer *l) {
+  float q = l->seq_len > 0 ? l->seq_len : 1;
+  float kv = l->kv_len > 0 ? l->kv_len : q;
+  return l->window > 0 && l->window < kv ? l->window : kv;
+}
+
+//cached keys the whole sequence reads, the windows of consecutive queries overlap
+static float attention_keys(layer *l) {
+  float q = l->seq_len > 0 ? l->seq_len : 1;
+  float kv = l->kv_len > 0 ? l->kv_len : q;
+  if (l->window <= 0) return kv;
+  return q - 1 + l->window < kv ? q - 1 + l->window : kv;
+}
+
+float kv_cache_bytes(asic *hardware, layer *l) {
+  int batch = l->batch > 0 ? l->batch : 1;
+  int kv_heads = l->kv_heads > 0 ? l->kv_heads : l->heads;
+  return 2.0 * batch * attention_span(l) * kv_heads * (l->c / l->heads) * dtype_size(hardware->mac_dtype);
+}
+
+int attention_block(asic *hardware, layer *l, int *passes) {
+  int mac_dtype = dtype_size(hardware->mac_dtype);
+  float q = l->seq_len > 0 ? l->seq_len : 1;
+  float kv = attention_keys(l);
+  float d = l->c / l->heads;
+  float budget = hardware->sram_size * 1024.0;
+  //b rows of q, of the fp32 output accumulator, of k and of v, and the b x b fp32 scores:
+  //4b^2 + (3 mac_dtype + 4) d b <= budget
+  float lin = (3.0 * mac_dtype + 4) * d;
+  int b = (int)floor((-lin + sqrt(lin * lin + 16 * budget)) / 8);
+  if (b < 1) b = 1;
+  if (b > q) b = q;
+  //the whole head's k/v next to one q block is read once
+  if (2.0 * kv * d * mac_dtype + b * d * (mac_dtype + 4.0) + 4.0 * b * kv <= budget) *passes = 1;
+  else *passes = (int)ceil(q / b);
+  return b;
+}
+
+void moe_expected_loads(layer *l, float *loads, float *active) {
+  float tokens = (float)(l->batch > 0 ? l->batch : 1) * (l->seq_len > 0 ? l->seq_len : 1);
+  int e;
+  for (e = 0; e < l->experts; ++e) {
+    //a token picks top_k distinct experts, so one expert at most once
+    float p = l->top_k * l->routing[e];
+    if (p > 1) p = 1;
+    loads[e] = tokens * p;
+    active[e] = 1 - pow(1 - p, tokens);
+  }
+}
+
+//one expert's ffn over rows tokens, up (and gate) then down projection; the activation
+//and gating product are elementwise on the vector alu
+//vector alu work beside the main unit, counted in aux_ops so it is charged energy
+static float aux_time(asic *hardware, layer_cost *c, float ops) {
+  float t = alu_time(hardware, VECTOR_UNIT, ops, vector_eff(hardware));
+  c->aux_ops += ops;
+  c->aux_perf += t;
+  return t;
+}
+
+static float expert_perf(asic *hardware, layer *l, float rows, layer_cost *c) {
+  int m = (int)ceil(rows);
+  int up = l->gated ? 2 : 1;
+  float pipe = pipe_efficiency(hardware, TENSOR_UNIT);
+  float o_up = 2.0 * up * rows * l->inputs * l->hidden;
+  float o_down = 2.0 * rows * l->hidden * l->inputs;
+  c->ops += o_up + o_down;
+  float t = alu_time(hardware, TENSOR_UNIT, o_up, gemm_utilisation(hardware, m, up * l->hidden, l->inputs) * pipe);
+  t += alu_time(hardware, TENSOR_UNIT, o_down, gemm_utilisation(hardware, m, l->inputs, l->hidden) * pipe);
+  t += aux_time(hardware, c, (float)up * rows * l->hidden);
+  return t;
+}
+
+//sum of i^-s for i = 1..n, by euler-maclaurin so a vocab of millions costs nothing
+static double zipf_mass(double n, double s) {
+  double integral = fabs(s - 1) < 1e-6 ? log(n) : (pow(n, 1 - s) - 1) / (1 - s);
+  return integral + 0.5 * (1 + pow(n, -s)) + s / 12 * (1 - pow(n, -s - 1));
+}
+
+float embedding_hit_rate(asic *hardware, layer *l) {
+  if (l->hit_rate >= 0) return l->hit_rate;
+  float row = (float)dtype_size(hardware->mac_dtype) * l->c;
+  int kb = l->cache < hardware->sram_size ? l->cache : hardware->sram_size;
+  float rows = floor(kb * 1024.0 / row);
+  if (rows < 1 || l->vocab < 1) return 0;
+  if (rows >= l->vocab) return 1;
+  if (l->zipf <= 0) return rows / l->vocab;
+  return zipf_mass(rows, l->zipf) / zipf_mass(l->vocab, l->zipf);
+}
+
+CONV_ALGO fastest_conv(asic *hardware, layer *l, layer_impl impl) {
+  CONV_ALGO best = CONV_DIRECT;
+  float fastest = 0;
+  int a;
+  for (a = CONV_DIRECT; a < NUM_CONV_ALGOS; ++a) {
+    if (!conv_algo_applies(l, (CONV_ALGO)a) || !conv_algo_exact(hardware, (CONV_ALGO)a)) continue;
+    impl.conv = (CONV_ALGO)a;
+    layer_cost c = cost_layer_impl(hardware, l, &impl);
+    float t = layer_latency(&c);
+    if (a == CONV_DIRECT || t < fastest) {
+      fastest = t;
+      best = (CONV_ALGO)a;
+    }
+  }
+  return best;
+}
+
+layer_impl default_impl(asic *hardware, layer *l) {
+  layer_impl impl = {0};
+  impl.unit = VECTOR_UNIT;
+  if (l->type == CONVOLUTIONAL || l->type == CONNECTED || l->type == RNN || l->type == LSTM || l->type == MOE) {
+    impl.unit = TENSOR_UNIT;
+  }
+  impl.taylor = hardware->surpass_num == 0;
+  impl.conv = CONV_DIRECT;
+  impl.attention = l->flash ? ATTN_FLASH : ATTN_NAIVE;
+  if (l->type == CONVOLUTIONAL && l->conv_algo != CONV_AUTO) impl.conv = (CONV_ALGO)l->conv_algo;
+  if (l->type == CONVOLUTIONAL && l->conv_algo == CONV_AUTO) impl.conv = fastest_conv(hardware, l, impl);
+  return impl;
+}
+
+float layer_latency(layer_cost *c) {
+  return c->alu_perf > c->mem_perf ? c->alu_perf : c->mem_perf;
+}
+
+layer_cost cost_layer(asic *hardware, layer *l) {
+  layer_impl impl = default_impl(hardware, l);
+  return cost_layer_impl(hardware, l, &impl);
+}
+
+layer_cost cost_layer_impl(asic *hardware, layer *l, layer_impl *impl) {
+  ++prof_count.layers;
+  int mac_dtype = dtype_size(hardware->mac_dtype);
+  int vec_dtype = dtype_size(hardware->vec_dtype);
+  int surpass_dtype = dtype_size(hardware->surpass_dtype);
+  int batch = l->batch > 0 ? l->batch : 1;
+  int tokens = l->seq_len > 0 ? l->seq_len : 1;
+  layer_cost c = {0};
+  float eff = 0;
+
+  c.unit = VECTOR_UNIT;
+  if(l->type == CONVOLUTIONAL) {
+    int groups = l->groups > 0 ? l->groups : 1;
+    c.unit = impl->unit;
+    //ops
+    c.ops = 2.0 * l->n * l->size * l->size * (l->c / groups) * l->out_h * l->out_w;
+    // filter_num * filter_size^2 * channels per group * out_h * out_w
+
+    //mem
+    c.mem_in += mac_dtype * l->w * l->h * l->c;
+    c.mem_weight += mac_dtype * l->size * l->size * (l->c / groups) * l->n;
+    c.mem_out += vec_dtype * l->n * l->out_h * l->out_w;
+
+    //perf
+    if (impl->conv == CONV_IM2COL) {
+      //the vector alu unfolds the input into a (c*size^2) x (out_h*out_w) matrix, which
+      //goes back offchip and is read again when it doesn't fit in the buffer
+      float unfold = (float)l->c * l->size * l->size * l->out_h * l->out_w;
+      c.in_pattern = SEQUENTIAL;
+      if (mac_dtype * unfold > hardware->sram_size * 1024.0) c.mem_in += 2 * mac_dtype * unfold;
+      eff = c.unit == VECTOR_UNIT ? vector_eff(hardware) : gemm_utilisation(hardware, batch * l->out_h * l->out_w,
+          l->n / groups, l->c / groups * l->size * l->size) * pipe_efficiency(hardware, TENSOR_UNIT);
+      c.aux_ops = unfold;
+      c.alu_perf = alu_time(hardware, c.unit, c.ops, eff);
+    } else if (impl->conv == CONV_WINOGRAD2 || impl->conv == CONV_WINOGRAD4) {
+      //every m x m output tile is t x t elementwise products of transformed input and filter
+      //tiles summed over channels, t*t gemms of (tiles x c) x (c x n); the filters are
+      //transformed offline and stored as t x t tiles
+      int m = impl->conv == CONV_WINOGRAD2 ? 2 : 4, t = m + 2;
+      float tiles = (float)((l->out_h + m - 1) / m) * ((l->out_w + m - 1) / m);
+      float transformed = (float)t * t * tiles * l->c;
+      c.ops = 2.0 * t * t * tiles * l->c * l->n;
+      c.mem_weight = mac_dtype * (float)t * t * l->c * l->n;
+      c.in_pattern = SEQUENTIAL;
+      if (mac_dtype * transformed > hardware->sram_size * 1024.0) c.mem_in += 2 * mac_dtype * transformed;
+      eff = c.unit == VECTOR_UNIT ? vector_eff(hardware) : gemm_utilisation(hardware, batch * (int)tiles, l->n, l->c)
+          * pipe_efficiency(hardware, TENSOR_UNIT);
+      //B^T d B on every input tile and A^T M A on every output tile, the transform matrices
+      //taken as half zeros
+      c.aux_ops = (float)t * t * t * tiles * l->c + (float)t * m * (t + m) * tiles * l->n;
+      c.alu_perf = alu_time(hardware, c.unit, c.ops, eff);
+    } else if (impl->conv == CONV_FFT) {
+      //real ffts of every padded input plane, one complex mac per channel, filter and
+      //frequency, and inverse ffts of the output planes; the filters' spectra are stored
+      int fh = 1, fw = 1;
+      while (fh < l->h + 2 * l->pad) fh *= 2;
+      while (fw < l->w + 2 * l->pad) fw *= 2;
+      float points = (float)fh * fw;
+      float fft = 2.5 * points * log2(points);
+      c.ops = 4.0 * points * l->c * l->n;
+      c.mem_weight = mac_dtype * points * l->c * l->n;
+      c.in_pattern = SEQUENTIAL;
+      if (mac_dtype * points * l->c > hardware->sram_size * 1024.0) c.mem_in += 2 * mac_dtype * points * l->c;
+      //each frequency has its own filters, so a gemm only batches the samples
+      eff = c.unit == VECTOR_UNIT ? vector_eff(hardware) : gemm_utilisation(hardware, batch, l->n, l->c)
+          * pipe_efficiency(hardware, TENSOR_UNIT);
+      c.aux_ops = fft * (l->c + l->n);
+      c.alu_perf = alu_time(hardware, c.unit, c.ops, eff);
+    } else {
+      //the loader fetches one input row of every channel plane per tile row
+      c.in_pattern = STRIDED;
+      c.in_run = mac_dtype * l->w;
+      //完成一次conv的时间
+      eff = c.unit == VECTOR_UNIT ? vector_eff(hardware) : conv_utilisation(hardware, l) * pipe_efficiency(hardware, TENSOR_UNIT);
+      c.alu_perf = alu_time(hardware, c.unit, c.ops, eff);
+    }
+    if (c.aux_ops > 0) {
+      c.aux_perf = alu_time(hardware, VECTOR_UNIT, c.aux_ops, vector_eff(hardware));
+      c.alu_perf += c.aux_perf;
+    }
+  } else if(l->type == BATCHNORM) {
+    //ops
+    c.ops += l->w * l->h * l->c; //for mean
+    c.ops += l->w * l->h * l->c * 4; //for var
+    c.ops += l->w * l->h * l->c; //for scale
+    c.ops += l->w * l->h * l->c * 2; //for bias
+
+    //mem
+    c.mem_in += l->w * l->h * l->c * vec_dtype;
+    c.mem_out += l->w * l->h * l->c * vec_dtype;
+
+    //perf
+    eff = vector_eff(hardware);
+    c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+  } else if(l->type == ACTIVE) {
+    if(!impl->taylor) {  //using surpass alu
+      c.unit = SURPASS_UNIT;
+      //ops
+      c.ops += l->inputs;
+
+      //mems
+      c.mem_in += surpass_dtype * l->inputs;
+      c.mem_out += surpass_dtype * l->inputs;
+
+      //perf
+      eff = hardware->surpass_eff/100;
+      c.alu_perf = alu_time(hardware, SURPASS_UNIT, c.ops, eff);
+    } else { //using taylor expansion, 1/(1+e^(-x)) = 1/2 + (1/4)*x - (1/48)*x^3
+      //ops
+      c.ops += 3 * l->inputs + 2 * l->inputs + 4 * l->inputs;
+
+      //mems
+      c.mem_in += vec_dtype * l->inputs;
+      c.mem_out += vec_dtype * l->inputs;
+
+      //perf
+      eff = vector_eff(hardware);
+      c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+    }
+  } else if(l->type == RELU) {
+    //ops
+    c.ops += l->inputs;
+
+    //mems
+    c.mem_in += vec_dtype * l->inputs;
+    c.mem_out += vec_dtype * l->inputs;
+
+    //perf
+    eff = hardware->ave_alu_eff/100;
+    c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+  } else if(l->type == AVGPOOL || l->type == MAXPOOL) {
+    //ops
+    c.ops += 2.0 * l->size * l->size * l->c * l->out_h * l->out_w;
+
+    //mem
+    c.mem_in += vec_dtype * l->c * l->w * l->h;
+    c.mem_out += vec_dtype * l->out_c * l->out_w * l->out_h;
+
+    //perf
+    eff = vector_eff(hardware);
+    c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+  } else if(l->type == CONNECTED) {
+    c.unit = impl->unit;
+    //mem
+    c.mem_in += mac_dtype * l->inputs;
+    c.mem_weight += (float)mac_dtype * l->inputs * l->outputs;
+    c.mem_out += vec_dtype * l->outputs;
+
+    //ops & perf
+    c.alu_perf = connected_perf(hardware, l, c.unit, &c.ops);
+  } else if (l->type == RNN || l->type == LSTM) {
+    //the input (and rnn output) projections of all steps are known up front and run as one
+    //gemm over steps x batch rows; the recurrent ones wait for the previous step's h
+    int steps = l->n > 0 ? l->n : 1;
+    float step_perf = 0, step_ops = 0;
+    c.unit = impl->unit;
+    //ops & perf
+    if (l->type == RNN) {
+      c.alu_perf += connected_perf(hardware, l->input_layer, c.unit, &c.ops);
+      c.alu_perf += connected_perf(hardware, l->output_layer, c.unit, &c.ops);
+      step_perf += connected_perf(hardware, l->self_layer, c.unit, &step_ops);
+    } else {
+      c.alu_perf += connected_perf(hardware, l->uf, c.unit, &c.ops);
+      c.alu_perf += connected_perf(hardware, l->ui, c.unit, &c.ops);
+      c.alu_perf += connected_perf(hardware, l->ug, c.unit, &c.ops);
+      c.alu_perf += connected_perf(hardware, l->uo, c.unit, &c.ops);
+      step_perf += connected_perf(hardware, l->wf, c.unit, &step_ops);
+      step_perf += connected_perf(hardware, l->wi, c.unit, &step_ops);
+      step_perf += connected_perf(hardware, l->wg, c.unit, &step_ops);
+      step_perf += connected_perf(hardware, l->wo, c.unit, &step_ops);
+    }
+    c.ops = (c.ops + step_ops) * steps;
+    c.alu_perf = (c.alu_perf + step_perf) * steps;
+
+    //mem: every step reads its x and writes its h, the states stay on chip; weights of the
+    //projections stream once, recurrent ones stay resident as far as the buffer holds them
+    //and the rest streams again every step
+    float recurrent = recurrent_weight_bytes(hardware, l);
+    float resident = resident_weight_bytes(hardware, l);
+    c.mem_in += (float)mac_dtype * l->inputs * steps;
+    if (l->type == RNN) {
+      c.mem_weight += (float)mac_dtype * l->input_layer->inputs * l->input_layer->outputs;
+      c.mem_weight += (float)mac_dtype * l->output_layer->inputs * l->output_layer->outputs;
+    } else {
+      c.mem_weight += (float)mac_dtype * l->uf->inputs * l->uf->outputs;
+      c.mem_weight += (float)mac_dtype * l->ui->inputs * l->ui->outputs;
+      c.mem_weight += (float)mac_dtype * l->ug->inputs * l->ug->outputs;
+      c.mem_weight += (float)mac_dtype * l->uo->inputs * l->uo->outputs;
+    }
+    c.mem_weight += resident + (recurrent - resident) * steps;
+    c.mem_out += (float)vec_dtype * l->outputs * steps;
+  } else if(l->type == LRN) {
+    float x = 100/hardware->surpass_eff;
+    if (impl->taylor) {  //taylor expansion, 1/x
+      x = 10; //approximation
+    }
+    //ops
+    c.ops += l->c * l->h * l->w * (2 * l->n * l->n * x + 2);
+
+    //mem
+    c.mem_in += vec_dtype * l->c * l->w * l->h;
+    c.mem_out += vec_dtype * l->c * l->w * l->h;
+
+    //perf
+    eff = vector_eff(hardware);
+    c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+  } else if(l->type == DECONV) {
+    //ops
+    c.ops += 2.0 * l->n * l->size * l->size * l->c * l->h * l->w;
+
+    //mem
+    c.mem_in += vec_dtype * l->w * l->h * l->c;
+    c.mem_weight += vec_dtype * l->size * l->size * l->c * l->n;
+    c.mem_out += vec_dtype * l->n * l->out_h * l->out_w;
+
+    //perf
+    if (impl->unit == TENSOR_UNIT) {
+      //gemm of the input pixels against every filter tap, then col2im adds the overlapping taps
+      c.unit = TENSOR_UNIT;
+      eff = gemm_utilisation(hardware, batch * l->h * l->w, l->n * l->size * l->size, l->c) * pipe_efficiency(hardware, TENSOR_UNIT);
+      c.alu_perf = alu_time(hardware, TENSOR_UNIT, c.ops, eff);
+      c.alu_perf += alu_time(hardware, VECTOR_UNIT, (float)l->n * l->size * l->size * l->h * l->w, vector_eff(hardware));
+    } else {
+      eff = vector_eff(hardware);
+      c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+    }
+  } else if(l->type == SHORTCUT) {
+    //ops
+    c.ops += l->outputs;
+
+    //mem, both operands are read
+    c.mem_in += 2.0 * vec_dtype * l->inputs;
+    c.mem_out += vec_dtype * l->outputs;
+
+    //perf
+    eff = vector_eff(hardware);
+    c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+  } else if(l->type == ATTENTION) {
+    c.unit = TENSOR_UNIT;
+    float q = l->seq_len > 0 ? l->seq_len : 1;
+    float kv = attention_span(l);
+    float keys = attention_keys(l);
+    int head_dim = l->c / l->heads;
+    //k and v are kv_heads wide, each shared by heads / kv_heads queries
+    float kv_width = (float)(l->kv_heads > 0 ? l->kv_heads : l->heads) * head_dim;
+    float scores = (float)l->heads * q * kv;
+    float pipe = pipe_efficiency(hardware, TENSOR_UNIT);
+
+    //ops, q.k^T and p.v per head
+    c.ops = 2 * 2.0 * q * kv * l->c;
+
+    if (impl->attention == ATTN_FLASH) {
+      //mem, q is read and the output written once, k/v once per pass over the q blocks,
+      //each pass only over the keys the block's windows cover
+      int passes;
+      int b = attention_block(hardware, l, &passes);
+      int bkv = passes == 1 ? kv : b;
+      float pass_keys = passes > 1 && l->window > 0 && b - 1 + l->window < keys ? b - 1 + l->window : keys;
+      c.mem_in += mac_dtype * q * l->c;
+      c.mem_in += (float)mac_dtype * 2 * pass_keys * kv_width * passes;
+      c.mem_out += vec_dtype * q * l->c;
+
+      //perf, the gemms run block by block; every k/v block rescales the running output,
+      //max and sum of each row, and the output is divided by the sum at the end
+      c.alu_perf = alu_time(hardware, TENSOR_UNIT, c.ops / 2, gemm_utilisation(hardware, b, bkv, head_dim) * pipe);
+      c.alu_perf += alu_time(hardware, TENSOR_UNIT, c.ops / 2, gemm_utilisation(hardware, b, head_dim, bkv) * pipe);
+      float blocks = ceil(kv / bkv);
+      c.alu_perf += aux_time(hardware, &c, (float)l->heads * q * (blocks * (head_dim + 4) + head_dim));
+    } else {
+      //mem, q and the k/v cache in, and the naive way the score matrix goes offchip
+      //after q.k^T and again after the softmax, read back each time
+      c.mem_in += mac_dtype * (q * l->c + 2 * keys * kv_width);
+      c.mem_in += 2.0 * vec_dtype * scores;
+      c.mem_out += 2.0 * vec_dtype * scores;
+      c.mem_out += vec_dtype * q * l->c;
+
+      //perf, two batched gemms on the tensor alu and the softmax in between
+      c.alu_perf = alu_time(hardware, TENSOR_UNIT, c.ops / 2, gemm_utilisation(hardware, batch * q, kv, head_dim) * pipe);
+      c.alu_perf += alu_time(hardware, TENSOR_UNIT, c.ops / 2, gemm_utilisation(hardware, batch * q, head_dim, kv) * pipe);
+    }
+    //max, subtract, sum and scale on the vector alu, exp like the activation layer
+    c.alu_perf += aux_time(hardware, &c, 4 * scores);
+    if (!impl->taylor) {
+      c.surpass_ops += scores;
+      c.alu_perf += alu_time(hardware, SURPASS_UNIT, scores, hardware->surpass_eff/100);
+    } else {
+      c.alu_perf += aux_time(hardware, &c, 9 * scores);
+    }
+  } else if(l->type == MOE) {
+    c.unit = TENSOR_UNIT;
+    float t = (float)batch * tokens;
+    int matrices = l->gated ? 3 : 2;
+    float pipe = pipe_efficiency(hardware, TENSOR_UNIT);
+    float loads[MAX_EXPERTS], active[MAX_EXPERTS];
+    int e;
+    if (impl->loads) {
+      for (e = 0; e < l->experts; ++e) {
+        loads[e] = impl->loads[e];
+        active[e] = loads[e] > 0;
+      }
+    } else {
+      moe_expected_loads(l, loads, active);
+    }
+
+    //gate, a t x experts gemm, then softmax and top_k selection per token on the vector alu
+    c.ops = 2.0 * t * l->inputs * l->experts;
+    c.alu_perf = alu_time(hardware, TENSOR_UNIT, c.ops, gemm_utilisation(hardware, (int)t, l->experts, l->inputs) * pipe);
+    c.alu_perf += aux_time(hardware, &c, t * l->experts * (4 + l->top_k));
+    c.mem_in += (float)mac_dtype * t * l->inputs;
+    c.mem_weight += (float)mac_dtype * l->inputs * l->experts;
+
+    //experts run one after another on their own token groups, an expert that gets no token
+    //isn't fetched; the top_k outputs of each token are weighted and summed
+    for (e = 0; e < l->experts; ++e) {
+      if (loads[e] <= 0) continue;
+      c.alu_perf += expert_perf(hardware, l, loads[e], &c);
+      c.mem_weight += active[e] * mac_dtype * matrices * (float)l->inputs * l->hidden;
+    }
+    c.ops += 2.0 * t * l->top_k * l->outputs;
+    c.alu_perf += alu_time(hardware, VECTOR_UNIT, 2.0 * t * l->top_k * l->outputs, vector_eff(hardware));
+    c.mem_out += (float)vec_dtype * t * l->outputs;
+  } else if(l->type == EMBEDDING) {
+    //every lookup the hot-row cache misses is an independent gather of one row
+    float row = (float)mac_dtype * l->c;
+    float misses = l->lookups * (1 - embedding_hit_rate(hardware, l));
+    c.mem_in += 4.0 * l->lookups;
+    c.mem_in += misses * row;
+    c.in_pattern = GATHER;
+    c.in_run = row;
+    c.in_requests = misses;
+    c.mem_out += (float)vec_dtype * l->outputs;
+    if (l->pooled) {
+      c.ops = (float)l->lookups * l->c;
+      c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, vector_eff(hardware));
+    }
+  } else if(l->type == UNPOOL) {
+    //ops
+    c.ops += l->size * l->size * l->c * l->out_h * l->out_w;
+
+    //mem
+    c.mem_in += vec_dtype * l->w * l->h * l->c;
+    c.mem_out += vec_dtype * l->out_c * l->out_h * l->out_w;
+
+    //perf
+    eff = vector_eff(hardware);
+    c.alu_perf = alu_time(hardware, VECTOR_UNIT, c.ops, eff);
+  }
+
+  //everything above is for one sample (one token of it, attention costs its whole sequence),
+  //weights are shared by the whole batch; moe routes the whole batch at once
+  float samples = batch * (l->type == ATTENTION ? 1 : tokens);
+  if (l->type == MOE) samples = 1;
+  if (samples > 1) {
+    c.ops *= samples;
+    c.aux_ops *= samples;
+    c.surpass_ops *= samples;
+    c.mem_in *= samples;
+    c.mem_out *= samples;
+    c.in_requests *= samples;
+    c.alu_perf *= samples;
+    c.aux_perf *= samples;
+  }
+
+  //a per layer type efficiency replaces the one of the unit
+  if (hardware->type_eff[l->type] > 0) {
+    c.alu_perf *= unit_efficiency(hardware, c.unit) / hardware->type_eff[l->type];
+    c.aux_perf *= unit_efficiency(hardware, c.unit) / hardware->type_eff[l->type];
+  }
+
+  //weights that don't fit in the tile are streamed in passes, and the input is read again
+  //every pass unless it stays in the rest of the buffer
+  if (impl->tile > 0 && c.mem_weight > 0) {
+    int passes = (int)ceil(c.mem_weight / (impl->tile * 1024.0));
+    if (passes > 1 && c.mem_in > (hardware->sram_size - impl->tile) * 1024.0) c.mem_in *= passes;
+  }
+  //data passed on chip between fused layers never goes offchip
+  if (impl->in_onchip) c.mem_in = c.in_requests = 0;
+  if (impl->out_onchip) c.mem_out = 0;
+
+  //utilisation actually achieved on the chosen alu, derived back from the time so
+  //that multi-gemm layers report their ops-weighted value
+  if (c.alu_perf > 0) {
+    c.util = 100 * alu_time(hardware, c.unit, c.ops, 1) / c.alu_perf;
+  }
+  //weights stream sequentially, so do outputs; inputs follow the layer's access pattern
+  c.mem = c.mem_in + c.mem_weight + c.mem_out;
+  c.mem_perf = mem_time(hardware, c.mem_in, dram_efficiency(hardware, c.in_pattern, c.mem_in, c.in_run));
+  //gathers can't all be in flight at once, a latency bound the bandwidth alone misses
+  if (c.in_requests > 0) {
+    float wait = gather_latency_time(hardware, c.in_requests);
+    if (wait > c.mem_perf) c.mem_perf = wait;
+  }
+  c.mem_perf += mem_time(hardware, c.mem_weight, dram_efficiency(hardware, SEQUENTIAL, c.mem_weight, 0));
+  c.mem_perf += mem_time(hardware, c.mem_out, dram_efficiency(hardware, SEQUENTIAL, c.mem_out, 0));
+  c.bw_eff = c.mem_perf > 0 ? 100 * mem_time(hardware, c.mem, 1) / c.mem_perf : hardware->ave_bw_eff;
+  c.energy = layer_energy(hardware, &c);
+  return c;
+}
+
+net_cost cost_network(asic *hardware, network *net) {
+  net_cost n = {0};
+  int i;
+  ++prof_count.networks;
+  //the whole model, layers of a block once per block
+  for (i = 0; i < net->n; ++i) {
+    layer_cost c = cost_layer(hardware, &net->layers[i]);
+    float r = layer_repeats(net, &net->layers[i]);
+    n.ops += r * c.ops;
+    n.mem += r * c.mem;
+    n.alu_perf += r * c.alu_perf;
+    n.mem_perf += r * c.mem_perf;
+    n.energy += r * c.energy;
+  }
+  n.peak_perf = n.alu_perf > n.mem_perf ? n.alu_perf : n.mem_perf;
+  n.worst_perf = n.alu_perf + n.mem_perf;
+  n.energy += static_energy(hardware, n.peak_perf);
+  return n;
+}
@@ -0,0 +1,67 @@
+#include <math.h>
+#include <string.h>
+
+#include "dims.h"
+#include "cost.h"
+#include "network.h"
+#include "option.h"
+#include "parser.h"
+#include "utils.h"
+
+int parse_dim(char *s, char *name, float *values, int max) {
+  char *eq = strchr(s, '=');
+  if (!eq || eq == s || eq - s > 31) error("--dim takes NAME=values");
+  strncpy(name, s, eq - s);
+  name[eq - s] = 0;
+  return parse_range_list(eq + 1, values, max);
+}
+
+//largest activation a layer keeps live, its input and output at once
+static float activation_bytes(asic *hardware, layer *l) {
+  int batch = l->batch > 0 ? l->batch : 1;
+  int tokens = l->seq_len > 0 ? l->seq_len : 1;
+  float bytes = (float)(l->inputs + l->outputs) * batch * tokens * dtype_size(hardware->vec_dtype);
+  if (l->type == ATTENTION && !l->flash) {
+    //the naive score matrix
+    bytes += (float)batch * l->heads * tokens * attention_span(l) * dtype_size(hardware->vec_dtype);
+  }
+  return bytes;
+}
+
+void dims_report(asic *hardware, list *sections, char *name, float *values, int n) {
+  int k, i;
+  float last_peak = 0, last_value = 0;
+  printf("===========dimension sweep================\n");
+  printf("%10s  %10s  %10s  %12s  %14s  %8s  %12s  %10s  %8s\n", name, "GOPs", "Data(MB)", "Act(MB)",
+      "Latency(us)", "Bound", "us/token", "Attn(%)", "Order");
+  for (k = 0; k < n; ++k) {
+    int value = (int)(values[k] + 0.5f);
+    bind_symbol(name, value);
+    network net = parse_network_sections(sections);
+    net_cost c = cost_network(hardware, &net);
+    float act = 0, attention = 0, layers = 0;
+    for (i = 0; i < net.n; ++i) {
+      layer_cost lc = cost_layer(hardware, &net.layers[i]);
+      float t = layer_latency(&lc);
+      float a = activation_bytes(hardware, &net.layers[i]);
+      if (a > act) act = a;
+      t *= layer_repeats(&net, &net.layers[i]);
+      if (net.layers[i].type == ATTENTION) attention += t;
+      layers += t;
+    }
+    int tokens = (net.seq_len > 0 ? net.seq_len : 1) * net.batch;
+    printf("%10d  %10.3f  %10.3f  %12.3f  %14.5f  %8s  %12.5f  %10.2f", value, c.ops / 1e9, c.mem / (1024 * 1024),
+        act / (1024 * 1024), c.peak_perf, c.alu_perf > c.mem_perf ? "compute" : "memory", c.peak_perf / tokens,
+        layers > 0 ? 100 * attention / layers : 0);
+    //local exponent of latency in the dimension, 2 for a purely quadratic cost
+    if (k > 0 && last_peak > 0 && value != last_value && value > 0 && last_value > 0) {
+      printf("  %8.3f\n", log(c.peak_perf / last_peak) / log(value / last_value));
+    } else {
+      printf("  %8s\n", "-");
+    }
+    last_peak = c.peak_perf;
+    last_value = value;
+    free_network(net);
+  }
+  printf("===========dimension sweep================\n\n\n");
+}
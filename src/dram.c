@@ -0,0 +1,73 @@
+#include <math.h>
+
+#include "dram.h"
+
+char *get_access_string(ACCESS_PATTERN a) {
+  switch(a) {
+    case SEQUENTIAL:
+      return "sequential";
+    case STRIDED:
+      return "strided";
+    case GATHER:
+      return "gather";
+  }
+  return "sequential";
+}
+
+int has_dram_model(asic *hardware) {
+  return hardware->dram_page > 0;
+}
+
+float dram_access_efficiency(asic *hardware, ACCESS_PATTERN pattern, float run) {
+  if (!has_dram_model(hardware)) {
+    //without a dram model a gathered row still occupies whole bursts
+    if (pattern == GATHER && run > 0) return hardware->ave_bw_eff / 100 * run / (ceil(run / hardware->dram_burst) * hardware->dram_burst);
+    return hardware->ave_bw_eff / 100;
+  }
+  if (run <= 0) return 1;
+
+  int channels = hardware->dram_channels;
+  float burst = hardware->dram_burst;
+  float page = hardware->dram_page;
+
+  //partially used bursts still occupy the bus for a whole burst
+  float bursts = ceil(run / burst);
+  float burst_eff = run / (bursts * burst);
+
+  //every run opens the pages it touches; a gathered row lands at a random offset and
+  //usually straddles one more page than its size needs
+  float opens = ceil(run / page);
+  if (pattern == GATHER && run < page) opens += run / page;
+  float miss_rate = opens / bursts;
+  if (miss_rate > 1) miss_rate = 1;
+
+  //a row miss costs dram_row_miss ns, banks of a channel hide each other's misses
+  double channel_bw = (double)hardware->off_bw * 1024 * 1024 * 1024 / 1e9 / channels;   //bytes per ns
+  double t_burst = burst / channel_bw;
+  double t_miss = hardware->dram_row_miss / hardware->dram_banks;
+  float row_eff = t_burst / (t_burst + miss_rate * t_miss);
+
+  //average_bandwidth_efficiency is the ceiling a long sequential stream reaches once
+  //refresh, read/write turnaround and command overhead are paid
+  return (hardware->ave_bw_eff / 100) * burst_eff * row_eff;
+}
+
+float dram_efficiency(asic *hardware, ACCESS_PATTERN pattern, float bytes, float run) {
+  if (!has_dram_model(hardware)) return dram_access_efficiency(hardware, pattern, run);
+  if (bytes <= 0) return 1;
+  if (run <= 0 || run > bytes) run = bytes;
+
+  //a single sequential stream shorter than one interleave round leaves channels idle,
+  //strided and gathered runs are independent requests spread over all channels
+  int channels = hardware->dram_channels;
+  float channel_eff = 1;
+  if (pattern == SEQUENTIAL) {
+    float chunks = ceil(bytes / DRAM_INTERLEAVE);
+    if (chunks < channels) channel_eff = chunks / channels;
+  }
+  return dram_access_efficiency(hardware, pattern, run) * channel_eff;
+}
+
+float gather_latency_time(asic *hardware, float requests) {
+  return requests * hardware->latency / hardware->outstanding;
+}
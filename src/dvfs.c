@@ -0,0 +1,146 @@
+#include <math.h>
+
+#include "dvfs.h"
+#include "cost.h"
+#include "energy.h"
+#include "network.h"
+#include "utils.h"
+
+asic at_operating_point(asic *hardware, int k) {
+  asic a = *hardware;
+  float v = hardware->opp_volt[k] / hardware->volt;
+  a.freq = hardware->opp_freq[k];
+  //dynamic energy of the logic scales with V^2, leakage roughly with V; dram energy is off-chip
+  a.energy_mac_half *= v * v;
+  a.energy_mac_float *= v * v;
+  a.energy_vec *= v * v;
+  a.energy_surpass *= v * v;
+  a.energy_sram *= v * v;
+  a.static_pwr *= v;
+  if (hardware->opp_pwr[k] > 0) a.pwr = hardware->opp_pwr[k];
+  return a;
+}
+
+float steady_temperature(asic *hardware, float pwr) {
+  return hardware->ambient + pwr * hardware->thermal_res;
+}
+
+float throttle_time(asic *hardware, float pwr) {
+  if (hardware->thermal_res <= 0) return -1;
+  float t_ss = steady_temperature(hardware, pwr);
+  if (t_ss <= hardware->max_temp) return -1;
+  //first order rc: T(t) = T_ss - (T_ss - T_a) * exp(-t / tau)
+  return -hardware->thermal_tau * log(1 - (hardware->max_temp - hardware->ambient) / (t_ss - hardware->ambient));
+}
+
+//latency of a layer with compute and memory overlapped, and its energy over that time
+static void layer_point(asic *a, layer *l, float *latency, float *energy) {
+  layer_cost c = cost_layer(a, l);
+  *latency = layer_latency(&c);
+  if (has_energy_model(a)) *energy = c.energy + static_energy(a, *latency);
+  else *energy = a->pwr * *latency;
+}
+
+//average power of a point, from its energy model or the constant power at that point
+static float point_power(asic *a, net_cost *n) {
+  if (has_energy_model(a)) return n->energy / n->peak_perf;
+  return a->pwr;
+}
+
+//a point may run sustained when it neither exceeds tdp nor heats past max_temperature
+static int sustainable(asic *hardware, float pwr) {
+  if (hardware->tdp > 0 && pwr > hardware->tdp) return 0;
+  if (hardware->thermal_res > 0 && steady_temperature(hardware, pwr) > hardware->max_temp) return 0;
+  return 1;
+}
+
+void dvfs_report(asic *hardware, network *net, float slack) {
+  int k;
+  int i;
+  int n = hardware->opp_num;
+  if (n == 0) {
+    fprintf(stderr, "No dvfs operating points in the hardware cfg\n");
+    return;
+  }
+
+  float *pwr = (float*)xcalloc(n, sizeof(float));
+  float *lat = (float*)xcalloc(n, sizeof(float));
+  int fastest = 0;
+  printf("===========dvfs===========================\n");
+  printf("Point  Voltage(V)  Freq(GHz)   Latency(us)    Energy(uJ)   Power(W)");
+  printf(hardware->thermal_res > 0 ? "   Temp(C)  Throttle\n" : "\n");
+  for (k = 0; k < n; ++k) {
+    asic a = at_operating_point(hardware, k);
+    net_cost c = cost_network(&a, net);
+    float energy = has_energy_model(&a) ? c.energy : a.pwr * c.peak_perf;
+    lat[k] = c.peak_perf;
+    pwr[k] = point_power(&a, &c);
+    if (hardware->opp_freq[k] > hardware->opp_freq[fastest]) fastest = k;
+    printf("%5d  %10.3f  %9.3f  %12.5f  %12.5f  %9.4f", k, hardware->opp_volt[k], hardware->opp_freq[k],
+        c.peak_perf, energy, pwr[k]);
+    if (hardware->thermal_res > 0) {
+      float t = throttle_time(hardware, pwr[k]);
+      printf("  %8.2f  ", steady_temperature(hardware, pwr[k]));
+      if (t < 0) printf("no\n");
+      else printf("after %.3f s\n", t);
+    } else {
+      printf("\n");
+    }
+  }
+
+  //running back to back, the chip settles on the fastest point it can hold
+  int sustained = -1;
+  for (k = 0; k < n; ++k) {
+    if (!sustainable(hardware, pwr[k])) continue;
+    if (sustained < 0 || hardware->opp_freq[k] > hardware->opp_freq[sustained]) sustained = k;
+  }
+  if (hardware->thermal_res > 0 || hardware->tdp > 0) {
+    if (sustained < 0) {
+      printf("\nNo operating point can be sustained under the thermal limits\n");
+    } else if (sustained != fastest) {
+      printf("\nSustained: throttles from point %d to point %d, latency %.5f us -> %.5f us\n",
+          fastest, sustained, lat[fastest], lat[sustained]);
+    } else {
+      printf("\nSustained: point %d holds without throttling\n", fastest);
+    }
+  }
+
+  //per-layer choice: least energy within slack of the fastest point
+  float base_lat = 0, base_energy = 0;
+  float plan_lat = 0, plan_energy = 0;
+  int lowered = 0;
+  printf("\nLayer  Type             Point   Latency(us)    Energy(uJ)\n");
+  for (i = 0; i < net->n; ++i) {
+    asic top = at_operating_point(hardware, fastest);
+    float l0, e0;
+    layer_point(&top, &net->layers[i], &l0, &e0);
+    int best = fastest;
+    float best_l = l0, best_e = e0;
+    for (k = 0; k < n; ++k) {
+      asic a = at_operating_point(hardware, k);
+      float lk, ek;
+      layer_point(&a, &net->layers[i], &lk, &ek);
+      if (lk <= l0 * (1 + slack / 100) && ek < best_e) {
+        best = k;
+        best_l = lk;
+        best_e = ek;
+      }
+    }
+    if (best != fastest) ++lowered;
+    //rows are one run of the layer, the totals the whole model
+    float r = layer_repeats(net, &net->layers[i]);
+    base_lat += r * l0;
+    base_energy += r * e0;
+    plan_lat += r * best_l;
+    plan_energy += r * best_e;
+    printf("%5d  %-15s  %5d  %12.5f  %12.5f\n", i, get_layer_string(net->layers[i].type), best, best_l, best_e);
+  }
+  printf("\nPer-layer dvfs lowers %d of %d layers within %.1f%% latency slack\n", lowered, net->n, slack);
+  printf("Fixed point %d          : %.5f us, %.5f uJ\n", fastest, base_lat, base_energy);
+  printf("Per-layer points       : %.5f us, %.5f uJ (%.2f%% energy saved)\n", plan_lat, plan_energy,
+      base_energy > 0 ? 100 * (base_energy - plan_energy) / base_energy : 0);
+  printf("===========dvfs===========================\n\n\n");
+
+  free(pwr);
+  free(lat);
+}
@@ -0,0 +1,30 @@
+#include "energy.h"
+
+int has_energy_model(asic *hardware) {
+  return hardware->energy_mac_half > 0 || hardware->energy_mac_float > 0 || hardware->energy_vec > 0
+      || hardware->energy_surpass > 0 || hardware->energy_sram > 0 || hardware->energy_dram > 0
+      || hardware->static_pwr > 0;
+}
+
+float layer_energy(asic *hardware, layer_cost *c) {
+  double pj = 0;
+  if (c->unit == TENSOR_UNIT) {
+    //two operations per mac
+    float mac = hardware->mac_dtype == 2 ? hardware->energy_mac_float : hardware->energy_mac_half;
+    pj += (double)c->ops / 2 * mac;
+  } else if (c->unit == SURPASS_UNIT) {
+    pj += (double)c->ops * hardware->energy_surpass;
+  } else {
+    pj += (double)c->ops * hardware->energy_vec;
+  }
+  pj += (double)c->aux_ops * hardware->energy_vec;
+  pj += (double)c->surpass_ops * hardware->energy_surpass;
+  pj += (double)c->mem * hardware->energy_dram;
+  pj += (double)c->mem * 2 * hardware->energy_sram;
+  return pj / 1e6;
+}
+
+float static_energy(asic *hardware, float latency) {
+  //W * us = uJ
+  return hardware->static_pwr * latency;
+}
@@ -0,0 +1,262 @@
+#include <math.h>
+
+#include "engine.h"
+#include "cost.h"
+#include "utils.h"
+#include "dram.h"
+
+
+timeline *make_timeline() {
+  timeline *t = (timeline*)xcalloc(1, sizeof(timeline));
+  t->size = 1024;
+  t->slices = (slice*)xcalloc(t->size, sizeof(slice));
+  return t;
+}
+
+void timeline_insert(timeline *t, slice s) {
+  if (t->n == t->size) {
+    t->size *= 2;
+    t->slices = (slice*)xrealloc(t->slices, t->size * sizeof(slice));
+  }
+  t->slices[t->n++] = s;
+}
+
+void free_timeline(timeline *t) {
+  free(t->slices);
+  free(t);
+}
+
+static void fifo_init(inst_fifo *f, int size) {
+  f->head = 0;
+  f->n = 0;
+  f->size = size;
+  f->ids = (int*)xcalloc(size, sizeof(int));
+}
+
+//size is kept a power of two so wrapping is a mask
+static inline void fifo_push(inst_fifo *f, int id) {
+  if (f->n == f->size) {
+    int i;
+    int *ids = (int*)xcalloc(2 * f->size, sizeof(int));
+    for (i = 0; i < f->n; ++i) ids[i] = f->ids[(f->head + i) & (f->size - 1)];
+    free(f->ids);
+    f->ids = ids;
+    f->head = 0;
+    f->size *= 2;
+  }
+  f->ids[(f->head + f->n++) & (f->size - 1)] = id;
+}
+
+static inline int fifo_pop(inst_fifo *f) {
+  int id = f->ids[f->head];
+  f->head = (f->head + 1) & (f->size - 1);
+  --f->n;
+  return id;
+}
+
+engine *make_engine(asic *hardware, timeline *trace) {
+  engine *e = (engine*)xcalloc(1, sizeof(engine));
+  e->hardware = hardware;
+  e->trace = trace;
+  e->events = make_event_queue(64);
+  e->channel_free = (double*)xcalloc(hardware->dram_channels, sizeof(double));
+  return e;
+}
+
+void free_engine(engine *e) {
+  free_event_queue(e->events);
+  free(e->channel_free);
+  free(e);
+}
+
+//instructions of the layer being simulated and the ready queue of every track
+typedef struct program {
+    instruction *insts;
+    UNIT_TYPE unit;
+    float eff;
+    float load_eff;       //bandwidth efficiency of the input and weight loads
+    float store_eff;
+    inst_fifo ready[NUM_TRACKS];
+} program;
+
+static inline int inst_track(program *p, int id) {
+  return p->insts[id].type == INST_COMPUTE ? (int)p->unit : DMA_TRACK;
+}
+
+static inline int track_capacity(asic *hardware, int track) {
+  return track == DMA_TRACK ? hardware->dma_num : 1;
+}
+
+//reserve the dram channels a transfer is interleaved over, returns the time its last
+//byte leaves the channels and sets *first to when the first one starts moving;
+//the data arrives offchip_latency later
+static double dram_access(engine *e, float bytes, float eff, double *first) {
+  asic *hardware = e->hardware;
+  int channels = hardware->dram_channels;
+  //bytes per us each channel sustains
+  double channel_bw = ((double)hardware->off_bw * 1024 * 1024 * 1024 / (1000 * 1000)) * eff / channels;
+  int chunks = (int)ceil(bytes / DRAM_INTERLEAVE);
+  if (chunks > channels) chunks = channels;
+  if (chunks < 1) chunks = 1;
+
+  double end = e->now;
+  int k;
+  *first = -1;
+  for (k = 0; k < chunks; ++k) {
+    int ch = (e->next_channel + k) % channels;
+    double start = e->channel_free[ch] > e->now ? e->channel_free[ch] : e->now;
+    if (*first < 0 || start < *first) *first = start;
+    e->channel_free[ch] = start + (bytes / chunks) / channel_bw;
+    if (e->channel_free[ch] > end) end = e->channel_free[ch];
+  }
+  e->next_channel = (e->next_channel + chunks) % channels;
+  return end;
+}
+
+//a dma engine is released once its transfer leaves the channels (event -(id+1)) and keeps
+//other requests in flight while the data is still in offchip_latency; a transfer starts
+//when its channels do, so queueing behind busy channels isn't counted as dma work
+static void start_inst(engine *e, program *p, int id) {
+  instruction *inst = &p->insts[id];
+  inst->start = e->now;
+  ++e->busy[inst_track(p, id)];
+  if (inst->type == INST_COMPUTE) {
+    push_event(e->events, e->now + alu_time(e->hardware, p->unit, inst->amount, p->eff), id);
+  } else {
+    float eff = inst->type == INST_LOAD ? p->load_eff : p->store_eff;
+    double end = dram_access(e, inst->amount, eff, &inst->start);
+    push_event(e->events, end, -(id + 1));
+    push_event(e->events, end + e->hardware->latency, id);
+  }
+}
+
+static void release_track(engine *e, int track, double start) {
+  --e->busy[track];
+  e->busy_time[track] += e->now - start;
+}
+
+static void dispatch(engine *e, program *p) {
+  int t;
+  for (t = 0; t < NUM_TRACKS; ++t) {
+    int cap = track_capacity(e->hardware, t);
+    while (p->ready[t].n > 0 && e->busy[t] < cap) {
+      start_inst(e, p, fifo_pop(&p->ready[t]));
+    }
+  }
+}
+
+static void add_succ(instruction *insts, int from, int to) {
+  insts[from].succ[(int)insts[from].nsucc++] = to;
+  ++insts[to].deps;
+}
+
+//lowering: tile t is LOAD(3t) -> COMPUTE(3t+1) -> STORE(3t+2), computes run in order and
+//the on-chip buffer holds sram_size/tile_size tiles, at least two for double buffering
+static int lower_layer(asic *hardware, layer_cost c, program *p) {
+  float tile_bytes = hardware->tile_size * 1024;
+  int buffers = hardware->sram_size / hardware->tile_size;
+  float bytes_in = c.mem_in + c.mem_weight;
+  int tiles = (int)ceil(bytes_in / tile_bytes);
+  if (tiles < 1) tiles = 1;
+  if (buffers < 2) buffers = 2;
+
+  p->unit = c.unit;
+  p->eff = c.util > 0 ? c.util / 100 : 1;
+  float in_eff = dram_access_efficiency(hardware, c.in_pattern, c.in_run > 0 ? c.in_run : c.mem_in);
+  float weight_eff = dram_access_efficiency(hardware, SEQUENTIAL, c.mem_weight);
+  p->load_eff = bytes_in > 0 ? bytes_in / (c.mem_in / in_eff + c.mem_weight / weight_eff) : 1;
+  p->store_eff = dram_access_efficiency(hardware, SEQUENTIAL, c.mem_out);
+  p->insts = (instruction*)xcalloc(3 * tiles, sizeof(instruction));
+  int t;
+  for (t = 0; t < tiles; ++t) {
+    instruction *load = &p->insts[3*t];
+    instruction *compute = &p->insts[3*t + 1];
+    instruction *store = &p->insts[3*t + 2];
+    load->type = INST_LOAD;
+    load->amount = bytes_in / tiles;
+    compute->type = INST_COMPUTE;
+    compute->amount = c.ops / tiles;
+    store->type = INST_STORE;
+    store->amount = c.mem_out / tiles;
+    load->tile = compute->tile = store->tile = t;
+
+    add_succ(p->insts, 3*t, 3*t + 1);
+    add_succ(p->insts, 3*t + 1, 3*t + 2);
+    if (t + 1 < tiles) add_succ(p->insts, 3*t + 1, 3*(t + 1) + 1);
+    //tile t+buffers reuses the buffer of tile t once it is computed
+    if (t + buffers < tiles) add_succ(p->insts, 3*t + 1, 3*(t + buffers));
+  }
+  for (t = 0; t < NUM_TRACKS; ++t) fifo_init(&p->ready[t], 64);
+  return 3 * tiles;
+}
+
+double simulate_layer(engine *e, layer_cost c, int index) {
+  double t0 = what_time_is_it_now();
+  program p;
+  int n = lower_layer(e->hardware, c, &p);
+  int i;
+  for (i = 0; i < n; ++i) {
+    if (p.insts[i].deps == 0) fifo_push(&p.ready[inst_track(&p, i)], i);
+  }
+  dispatch(e, &p);
+
+  int done = 0;
+  while (done < n) {
+    event ev = pop_event(e->events);
+    e->now = ev.time;
+    ++e->nevents;
+    if (ev.id < 0) {
+      release_track(e, DMA_TRACK, p.insts[-ev.id - 1].start);
+      dispatch(e, &p);
+      continue;
+    }
+
+    instruction *inst = &p.insts[ev.id];
+    int track = inst_track(&p, ev.id);
+    if (inst->type == INST_COMPUTE) release_track(e, track, inst->start);
+    ++done;
+
+    if (e->trace) {
+      slice s;
+      s.type = (INST_TYPE)inst->type;
+      s.track = track;
+      s.layer = index;
+      s.tile = inst->tile;
+      s.amount = inst->amount;
+      s.start = inst->start;
+      s.end = ev.time;
+      timeline_insert(e->trace, s);
+    }
+
+    int k;
+    for (k = 0; k < inst->nsucc; ++k) {
+      int id = inst->succ[k];
+      if (--p.insts[id].deps == 0) fifo_push(&p.ready[inst_track(&p, id)], id);
+    }
+    dispatch(e, &p);
+  }
+
+  for (i = 0; i < NUM_TRACKS; ++i) free(p.ready[i].ids);
+  free(p.insts);
+  e->ntiles += n / 3;
+  e->wall += what_time_is_it_now() - t0;
+  return e->now;
+}
+
+void print_engine(engine *e) {
+  asic *hardware = e->hardware;
+  double total = e->now > 0 ? e->now : 1;
+  printf("===========event simulation===============\n");
+  printf("Simulated Cycles       : %.0f\n", e->now * hardware->freq * 1000);
+  printf("Simulated Latency      : %.5f us\n", e->now);
+  printf("Tiles                  : %ld\n", e->ntiles);
+  printf("Tensor Alu Busy        : %.3f%%\n", 100 * e->busy_time[TENSOR_UNIT] / total);
+  printf("Vector Alu Busy        : %.3f%%\n", 100 * e->busy_time[VECTOR_UNIT] / total);
+  if (hardware->surpass_num > 0) {
+    printf("Surpass Alu Busy       : %.3f%%\n", 100 * e->busy_time[SURPASS_UNIT] / total);
+  }
+  printf("DMA Busy               : %.3f%%\n", 100 * e->busy_time[DMA_TRACK] / (total * hardware->dma_num));
+  printf("Events                 : %ld (%.2f M events/s)\n", e->nevents,
+      e->wall > 0 ? e->nevents / e->wall / 1e6 : 0);
+  printf("===========event simulation===============\n\n\n");
+}
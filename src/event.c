@@ -0,0 +1,58 @@
+#include "event.h"
+#include "utils.h"
+
+event_queue *make_event_queue(int size) {
+  event_queue *q = (event_queue*)xcalloc(1, sizeof(event_queue));
+  q->size = size > 0 ? size : 16;
+  q->heap = (event*)xcalloc(q->size, sizeof(event));
+  return q;
+}
+
+static inline int event_before(event *a, event *b) {
+  if (a->time != b->time) return a->time < b->time;
+  return a->seq < b->seq;
+}
+
+void push_event(event_queue *q, double time, int id) {
+  if (q->n == q->size) {
+    q->size *= 2;
+    q->heap = (event*)xrealloc(q->heap, q->size * sizeof(event));
+  }
+  event e;
+  e.time = time;
+  e.seq = q->seq++;
+  e.id = id;
+
+  //sift up
+  int i = q->n++;
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!event_before(&e, &q->heap[parent])) break;
+    q->heap[i] = q->heap[parent];
+    i = parent;
+  }
+  q->heap[i] = e;
+}
+
+event pop_event(event_queue *q) {
+  event top = q->heap[0];
+  event last = q->heap[--q->n];
+
+  //sift down
+  int i = 0;
+  while (1) {
+    int child = 2 * i + 1;
+    if (child >= q->n) break;
+    if (child + 1 < q->n && event_before(&q->heap[child + 1], &q->heap[child])) ++child;
+    if (!event_before(&q->heap[child], &last)) break;
+    q->heap[i] = q->heap[child];
+    i = child;
+  }
+  q->heap[i] = last;
+  return top;
+}
+
+void free_event_queue(event_queue *q) {
+  free(q->heap);
+  free(q);
+}
@@ -0,0 +1,92 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "mapping.h"
+
+static int ceil_div(int a, int b) {
+  return (a + b - 1) / b;
+}
+
+static int max_int(int a, int b) {
+  return a > b ? a : b;
+}
+
+DATAFLOW get_dataflow(char *s) {
+  if (strcmp(s, "weight_stationary")==0 || strcmp(s, "ws")==0) return WEIGHT_STATIONARY;
+  if (strcmp(s, "output_stationary")==0 || strcmp(s, "os")==0) return OUTPUT_STATIONARY;
+  if (strcmp(s, "row_stationary")==0 || strcmp(s, "rs")==0)    return ROW_STATIONARY;
+  fprintf(stderr, "Couldn't find dataflow %s, going with weight_stationary\n", s);
+  return WEIGHT_STATIONARY;
+}
+
+char *get_dataflow_string(DATAFLOW d) {
+  switch(d) {
+    case WEIGHT_STATIONARY:
+      return "weight stationary";
+    case OUTPUT_STATIONARY:
+      return "output stationary";
+    case ROW_STATIONARY:
+      return "row stationary";
+  }
+  return "weight stationary";
+}
+
+int has_mac_array(asic *hardware) {
+  return hardware->mac_rows > 0 && hardware->mac_cols > 0;
+}
+
+//row stationary: filter rows on the array rows, output rows on the array columns,
+//(channel, filter) pairs are replicated vertically when a filter is shorter than the array
+static float rs_utilisation(asic *hardware, int size, int c, int n, int out_h, int out_w) {
+  int rows = hardware->mac_rows;
+  int cols = hardware->mac_cols;
+  int pairs = c * n;
+
+  int fold = ceil_div(size, rows);
+  int sets = size > rows ? 1 : rows / size;
+  if (sets > pairs) sets = pairs;
+  int passes = ceil_div(pairs, sets);
+
+  //every PE runs a 1-D convolution of one filter row over one output row
+  double cycles = (double)passes * fold * ceil_div(out_h, cols) * out_w * size + rows + cols;
+  double macs = (double)n * c * size * size * out_h * out_w;
+  return macs / (cycles * rows * cols);
+}
+
+float gemm_utilisation(asic *hardware, int m, int n, int k) {
+  if (!has_mac_array(hardware)) return hardware->ave_alu_eff / 100;
+  if (m < 1 || n < 1 || k < 1) return 1;
+
+  int rows = hardware->mac_rows;
+  int cols = hardware->mac_cols;
+  double tiles;
+  double cycles;
+
+  if (hardware->dataflow == ROW_STATIONARY) {
+    return rs_utilisation(hardware, 1, k, n, m, 1);
+  } else if (hardware->dataflow == OUTPUT_STATIONARY) {
+    //outputs pinned: m on rows, n on columns, k streams through
+    //draining a tile of accumulators takes one cycle per row and is double buffered
+    tiles = (double)ceil_div(m, rows) * ceil_div(n, cols);
+    cycles = tiles * max_int(k, rows) + rows + cols;
+  } else {
+    //weights pinned: k on rows, n on columns, m streams through
+    //loading a weight tile takes one cycle per row and is double buffered
+    tiles = (double)ceil_div(k, rows) * ceil_div(n, cols);
+    cycles = tiles * max_int(m, rows) + rows + cols;
+  }
+  return ((double)m * n * k) / (cycles * rows * cols);
+}
+
+float conv_utilisation(asic *hardware, layer *l) {
+  if (!has_mac_array(hardware)) return hardware->ave_alu_eff / 100;
+  int batch = l->batch > 0 ? l->batch : 1;
+  int groups = l->groups > 0 ? l->groups : 1;
+  //images of a batch are laid side by side along the output width; the filter/channel
+  //pairs of all groups are independent 1-D convolutions to row stationary
+  if (hardware->dataflow == ROW_STATIONARY) {
+    return rs_utilisation(hardware, l->size, l->c / groups, l->n, l->out_h, l->out_w * batch);
+  }
+  //groups run one after another as smaller gemms
+  return gemm_utilisation(hardware, batch * l->out_h * l->out_w, l->n / groups, l->c / groups * l->size * l->size);
+}
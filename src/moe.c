@@ -0,0 +1,95 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "moe.h"
+#include "cost.h"
+#include "utils.h"
+
+static int by_value(const void *a, const void *b) {
+  float x = *(float*)a, y = *(float*)b;
+  return x < y ? -1 : x > y;
+}
+
+//one routing of every token to top_k distinct experts, drawn without replacement
+static void draw_loads(layer *l, int tokens, float *loads) {
+  int chosen[MAX_EXPERTS];
+  int i, j, e;
+  for (e = 0; e < l->experts; ++e) loads[e] = 0;
+  for (i = 0; i < tokens; ++i) {
+    float left = 1;
+    for (e = 0; e < l->experts; ++e) chosen[e] = 0;
+    for (j = 0; j < l->top_k; ++j) {
+      float u = rand() / ((float)RAND_MAX + 1) * left;
+      int pick = -1;
+      for (e = 0; e < l->experts; ++e) {
+        if (chosen[e] || l->routing[e] <= 0) continue;
+        pick = e;
+        u -= l->routing[e];
+        if (u < 0) break;
+      }
+      if (pick < 0) break;
+      chosen[pick] = 1;
+      left -= l->routing[pick];
+      ++loads[pick];
+    }
+  }
+}
+
+void moe_report(asic *hardware, network *net) {
+  int i, k, e, any = 0;
+  float loads[MAX_EXPERTS], active[MAX_EXPERTS];
+  float *lat = (float*)xcalloc(MOE_TRIALS, sizeof(float));
+  float *imbalance = (float*)xcalloc(MOE_TRIALS, sizeof(float));
+  srand(MOE_SEED);
+  for (i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if (l->type != MOE) continue;
+    if (!any) printf("===========moe============================\n");
+    any = 1;
+    int tokens = (l->batch > 0 ? l->batch : 1) * (l->seq_len > 0 ? l->seq_len : 1);
+    float hottest = 0, expected_active = 0;
+    moe_expected_loads(l, loads, active);
+    for (e = 0; e < l->experts; ++e) {
+      if (l->routing[e] > hottest) hottest = l->routing[e];
+      expected_active += active[e];
+    }
+    layer_cost c = cost_layer(hardware, l);
+
+    //the same layer under sampled routings
+    layer_impl impl = default_impl(hardware, l);
+    float sum = 0, sum_active = 0, sum_imbalance = 0;
+    float mean_load = (float)tokens * l->top_k / l->experts;
+    for (k = 0; k < MOE_TRIALS; ++k) {
+      draw_loads(l, tokens, loads);
+      impl.loads = loads;
+      layer_cost s = cost_layer_impl(hardware, l, &impl);
+      float most = 0;
+      for (e = 0; e < l->experts; ++e) {
+        if (loads[e] > most) most = loads[e];
+        sum_active += loads[e] > 0;
+      }
+      lat[k] = layer_latency(&s);
+      imbalance[k] = mean_load > 0 ? most / mean_load : 0;
+      sum += lat[k];
+      sum_imbalance += imbalance[k];
+    }
+    qsort(lat, MOE_TRIALS, sizeof(float), by_value);
+    qsort(imbalance, MOE_TRIALS, sizeof(float), by_value);
+    int p50 = MOE_TRIALS / 2, p99 = (int)ceil(0.99 * MOE_TRIALS) - 1;
+
+    printf("Layer %d: %d experts, top %d, %d tokens, hidden %d%s\n", i, l->experts, l->top_k, tokens, l->hidden,
+        l->gated ? " (gated)" : "");
+    printf("Hottest Expert Share   : %.2f%%\n", 100 * hottest);
+    printf("Active Experts         : %.2f expected, %.2f sampled\n", expected_active, sum_active / MOE_TRIALS);
+    printf("Expected Latency       : %.5f us (expected loads, %s bound)\n", layer_latency(&c),
+        c.alu_perf > c.mem_perf ? "compute" : "memory");
+    printf("Sampled Latency        : %.5f mean, %.5f P50, %.5f P99, %.5f max us over %d routings\n",
+        sum / MOE_TRIALS, lat[p50], lat[p99], lat[MOE_TRIALS - 1], MOE_TRIALS);
+    printf("Max / Mean Expert Load : %.3f mean, %.3f P99\n", sum_imbalance / MOE_TRIALS, imbalance[p99]);
+    printf("Expert Weight Data     : %.3f MB (%.2f%% of the layer)\n\n", c.mem_weight / (1024 * 1024),
+        c.mem > 0 ? 100 * c.mem_weight / c.mem : 0);
+  }
+  if (any) printf("===========moe============================\n\n\n");
+  free(lat);
+  free(imbalance);
+}
@@ -15,6 +15,93 @@ network make_network(int n) {
   return net;
 }
 
+char *get_layer_string(LAYER_TYPE a) {
+  switch(a) {
+    case CONVOLUTIONAL:
+      return "convolutional";
+    case ACTIVE:
+      return "activation";
+    case DECONV:
+      return "deconvolutional";
+    case CONNECTED:
+      return "connected";
+    case RNN:
+      return "rnn";
+    case LSTM:
+      return "lstm";
+    case MAXPOOL:
+      return "maxpool";
+    case AVGPOOL:
+      return "avgpool";
+    case BATCHNORM:
+      return "batchnorm";
+    case RELU:
+      return "relu";
+    case LRN:
+      return "lrn";
+    case UNPOOL:
+      return "unpool";
+    case SHORTCUT:
+      return "shortcut";
+    case ROUTE:
+      return "route";
+    case ATTENTION:
+      return "attention";
+    case MOE:
+      return "moe";
+    case EMBEDDING:
+      return "embedding";
+    default:
+      break;
+  }
+  return "none";
+}
+
+static void set_batch_sublayer(layer *l, int b) {
+  if (l) l->batch = b;
+}
+
+void set_batch_network(network *net, int b) {
+  int i;
+  net->batch = b;
+  for (i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    l->batch = b;
+    if (l->antialiasing) set_batch_sublayer(l->input_layer, b);
+    if (l->type == RNN) {
+      set_batch_sublayer(l->input_layer, b);
+      set_batch_sublayer(l->self_layer, b);
+      set_batch_sublayer(l->output_layer, b);
+    }
+    if (l->type == LSTM) {
+      set_batch_sublayer(l->uf, b);
+      set_batch_sublayer(l->ui, b);
+      set_batch_sublayer(l->ug, b);
+      set_batch_sublayer(l->uo, b);
+      set_batch_sublayer(l->wf, b);
+      set_batch_sublayer(l->wi, b);
+      set_batch_sublayer(l->wg, b);
+      set_batch_sublayer(l->wo, b);
+    }
+  }
+}
+
+void set_tokens_network(network *net, int tokens) {
+  int i;
+  net->seq_len = tokens;
+  for (i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if (l->type == RNN || l->type == LSTM) continue;
+    l->seq_len = tokens;
+    if (l->type == ATTENTION && l->kv_len < tokens) l->kv_len = tokens;
+  }
+}
+
+int layer_repeats(network *net, layer *l) {
+  if (l->once || net->blocks < 1) return 1;
+  return net->blocks;
+}
+
 void free_sublayer(layer *l) {
   if (l) {
     free_layer(*l);
@@ -37,6 +124,9 @@ void free_layer(layer l) {
     free_sublayer(l.ug);
     free_sublayer(l.uo);
   }
+  if (l.type == MOE) {
+    free(l.routing);
+  }
   if (l.type == CRNN) {
     free_sublayer(l.input_layer);
     free_sublayer(l.self_layer);
@@ -1,7 +1,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include "option.h"
+#include "profile.h"
 #include "utils.h"
 
 list *read_data_cfg(char *filename) {
@@ -68,15 +70,18 @@ void option_unused(list *l) {
 }
 
 char *option_find(list *l, char *key) {
+  profile_begin(PROFILE_OPTIONS);
   node *n = l->front;
   while(n){
     kvp *p = (kvp *)n->val;
     if(strcmp(p->key, key) == 0){
       p->used = 1;
+      profile_end(PROFILE_OPTIONS);
       return p->val;
     }
     n = n->next;
   }
+  profile_end(PROFILE_OPTIONS);
   return 0;
 }
 
@@ -93,16 +98,129 @@ char *option_find_str_quiet(list *l, char *key, char *def) {
   return def;
 }
 
+typedef struct symbol {
+    char name[32];
+    int value;
+} symbol;
+
+static symbol symbols[MAX_SYMBOLS];
+static int nsymbols = 0;
+
+static symbol *find_symbol(char *name, int len) {
+  int i;
+  for (i = 0; i < nsymbols; ++i) {
+    if (strlen(symbols[i].name) == (size_t)len && strncmp(symbols[i].name, name, len) == 0) return &symbols[i];
+  }
+  return 0;
+}
+
+static void set_symbol(char *name, int value, int overwrite) {
+  symbol *s = find_symbol(name, strlen(name));
+  if (s) {
+    if (overwrite) s->value = value;
+    return;
+  }
+  if (nsymbols == MAX_SYMBOLS) error("too many symbolic dimensions");
+  strncpy(symbols[nsymbols].name, name, sizeof(symbols[nsymbols].name) - 1);
+  symbols[nsymbols++].value = value;
+}
+
+void bind_symbol(char *name, int value) {
+  set_symbol(name, value, 1);
+}
+
+void define_symbol(char *name, int value) {
+  set_symbol(name, value, 0);
+}
+
+//a cfg's defaults are only ever added after what is already bound, so dropping the
+//symbols past a saved count undoes them
+int save_symbols() {
+  return nsymbols;
+}
+
+void restore_symbols(int saved) {
+  if (saved >= 0 && saved < nsymbols) nsymbols = saved;
+}
+
+//expr = term {+|- term}, term = factor {*|/ factor}, factor = number | symbol | (expr) | -factor
+static long eval_expr(char **p);
+
+static long eval_factor(char **p) {
+  char *s = *p;
+  if (*s == '(') {
+    ++*p;
+    long v = eval_expr(p);
+    if (**p != ')') error("missing ) in dimension");
+    ++*p;
+    return v;
+  }
+  if (*s == '-') {
+    ++*p;
+    return -eval_factor(p);
+  }
+  if (isdigit((unsigned char)*s)) return strtol(s, p, 10);
+  int len = 0;
+  while (isalnum((unsigned char)s[len]) || s[len] == '_') ++len;
+  symbol *sym = len ? find_symbol(s, len) : 0;
+  if (!sym) {
+    fprintf(stderr, "undefined dimension in '%s'\n", s);
+    error("undefined dimension");
+  }
+  *p += len;
+  return sym->value;
+}
+
+static long eval_term(char **p) {
+  long v = eval_factor(p);
+  while (**p == '*' || **p == '/') {
+    char op = *(*p)++;
+    long r = eval_factor(p);
+    if (op == '/' && r == 0) error("division by zero in dimension");
+    v = op == '*' ? v * r : v / r;
+  }
+  return v;
+}
+
+static long eval_expr(char **p) {
+  long v = eval_term(p);
+  while (**p == '+' || **p == '-') {
+    char op = *(*p)++;
+    long r = eval_term(p);
+    v = op == '+' ? v + r : v - r;
+  }
+  return v;
+}
+
+int eval_dim(char *s) {
+  char *p = s;
+  long v = eval_expr(&p);
+  if (*p) {
+    fprintf(stderr, "can't parse dimension '%s'\n", s);
+    error("bad dimension");
+  }
+  return (int)v;
+}
+
+//plain numbers keep atoi's behaviour, anything naming a symbol is an expression
+static int option_int(char *v) {
+  char *s;
+  for (s = v; *s; ++s) {
+    if (isalpha((unsigned char)*s) || *s == '(') return eval_dim(v);
+  }
+  return atoi(v);
+}
+
 int option_find_int(list *l, char *key, int def) {
   char *v = option_find(l, key);
-  if(v) return atoi(v);
+  if(v) return option_int(v);
   fprintf(stderr, "%s: Using default '%d'\n", key, def);
   return def;
 }
 
 int option_find_int_quiet(list *l, char *key, int def) {
   char *v = option_find(l, key);
-  if(v) return atoi(v);
+  if(v) return option_int(v);
   return def;
 }
 
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -7,6 +8,9 @@
 #include "parser.h"
 #include "utils.h"
 #include "network.h"
+#include "mapping.h"
+#include "cost.h"
+#include "profile.h"
 
 typedef struct{
     char *type;
@@ -14,8 +18,6 @@ typedef struct{
 }section;
 
 
-list *read_cfg(char *filename);
-
 // 将对应的算子字符串转为枚举类别
 LAYER_TYPE string_to_layer_type(char * type) {
 
@@ -33,10 +35,16 @@ LAYER_TYPE string_to_layer_type(char * type) {
     if (strcmp(type, "[avg]")==0
         || strcmp(type, "[avgpool]")==0)         return AVGPOOL;
     if (strcmp(type, "[lrn]")==0)                return LRN;
-    if (strcmp(type, "[batchnorm]")==0)          return BATCHNORM;
+    if (strcmp(type, "[batchnorm]")==0
+        || strcmp(type, "[layernorm]")==0)       return BATCHNORM;
     if (strcmp(type, "[relu]")==0)               return RELU;
     if (strcmp(type, "[deconvolutional]")==0)    return DECONV;
     if (strcmp(type, "[unpool]") == 0)           return UNPOOL;
+    if (strcmp(type, "[shortcut]") == 0)         return SHORTCUT;
+    if (strcmp(type, "[route]") == 0)            return ROUTE;
+    if (strcmp(type, "[attention]") == 0)        return ATTENTION;
+    if (strcmp(type, "[moe]") == 0)              return MOE;
+    if (strcmp(type, "[embedding]") == 0)        return EMBEDDING;
     if (strcmp(type, "[empty]") == 0)            return EMPTY;
     return BLANK;
 }
@@ -59,7 +67,7 @@ void free_section(section *s) {
 
 //@conv
 layer parse_convolutional(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
 
   int n = option_find_int(options, "filters",1);
   int size = option_find_int(options, "size",1);
@@ -74,6 +82,7 @@ layer parse_convolutional(list *options, size_params params) {
   else {
     stride = option_find_int_quiet(options, "stride", 1);
   }
+  l.type = CONVOLUTIONAL;
   l.antialiasing = option_find_int_quiet(options, "antialiasing", 0);
 
   int share_index = option_find_int_quiet(options, "share_index", -1000000000);
@@ -82,15 +91,31 @@ layer parse_convolutional(list *options, size_params params) {
   else if(share_index != -1000000000) share_layer = &params.net.layers[params.index + share_index];
 
 
+  l.pad = option_find_int_quiet(options, "pad", 0);
+  l.groups = option_find_int_quiet(options, "groups", 1);
+  if (l.groups < 1 || params.c % l.groups || n % l.groups) {
+    fprintf(stderr, "groups %d doesn't divide %d channels and %d filters, using 1\n", l.groups, params.c, n);
+    l.groups = 1;
+  }
+
   l.h = params.h;
   l.w = params.w;
   l.c = params.c;
   l.size = size;
-  l.out_h = (params.h - size) / stride_y + 1;
-  l.out_w = (params.w - size) / stride_x + 1;
+  l.out_h = (params.h + 2 * l.pad - size) / stride_y + 1;
+  l.out_w = (params.w + 2 * l.pad - size) / stride_x + 1;
+  l.out_c = n;
   l.n = n;
   l.stride_x = stride_x;
   l.stride_y = stride_y;
+  l.inputs = l.h * l.w * l.c;
+  l.outputs = l.out_h * l.out_w * l.out_c;
+  l.conv_algo = get_conv_algo(option_find_str_quiet(options, "algo", "direct"));
+  if (l.conv_algo != CONV_AUTO && !conv_algo_applies(&l, (CONV_ALGO)l.conv_algo)) {
+    fprintf(stderr, "%s doesn't apply to a %dx%d convolution with stride %d and %d groups, using direct\n",
+        get_conv_string((CONV_ALGO)l.conv_algo), size, size, stride_x, l.groups);
+    l.conv_algo = CONV_DIRECT;
+  }
 
   return l;
 }
@@ -98,7 +123,7 @@ layer parse_convolutional(list *options, size_params params) {
 
 //@rnn
 layer parse_rnn(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
 
   int output = option_find_int(options, "output",1);
   int hidden = option_find_int(options, "hidden",1);
@@ -126,6 +151,8 @@ layer parse_rnn(list *options, size_params params) {
   l.input_layer->size = 1;
   l.input_layer->stride_x = 1;
   l.input_layer->stride_y = 1;
+  //input projections of every step run as one gemm
+  l.input_layer->seq_len = l.n;
 
   l.self_layer = (layer*)xcalloc(1, sizeof(layer));
   l.self_layer->type = CONNECTED;
@@ -156,6 +183,7 @@ layer parse_rnn(list *options, size_params params) {
   l.output_layer->size = 1;
   l.output_layer->stride_x = 1;
   l.output_layer->stride_y = 1;
+  l.output_layer->seq_len = l.n;
 
   l.outputs = output;
   return l;
@@ -165,9 +193,10 @@ layer parse_rnn(list *options, size_params params) {
 layer parse_lstm(list *options, size_params params) {
     int output = option_find_int(options, "output",1);
 
-    layer l;
+    layer l = { (LAYER_TYPE)0 };
 
     l.type = LSTM;
+    l.n = params.time_steps;
     l.inputs = params.inputs;
     l.out_w = 1;
     l.out_h = 1;
@@ -233,6 +262,8 @@ layer parse_lstm(list *options, size_params params) {
     l.uo->size = 1;
     l.uo->stride_x = 1;
     l.uo->stride_y = 1;
+    //input projections of every step run as one gemm, the recurrent ones step by step
+    l.uf->seq_len = l.ui->seq_len = l.ug->seq_len = l.uo->seq_len = l.n;
 
     l.wf = (layer*)xcalloc(1, sizeof(layer));
     l.wf->type = CONNECTED;
@@ -301,10 +332,11 @@ layer parse_lstm(list *options, size_params params) {
 //@fc
 layer parse_connected(list *options, size_params params) {
     int output = option_find_int(options, "output",1);
-    layer l;
+    layer l = { (LAYER_TYPE)0 };
 
     l.type = CONNECTED;
 
+    l.seq_len = params.seq_len;
     l.inputs = params.inputs;
     l.outputs = output;
     l.h = 1;
@@ -323,12 +355,20 @@ layer parse_connected(list *options, size_params params) {
 
 //@bn
 layer parse_batchnorm(list *options, size_params params) {
-    layer l;
+    layer l = { (LAYER_TYPE)0 };
 
     l.type = BATCHNORM;
-    l.h = params.h;
-    l.w = params.w;
-    l.c = params.c;
+    l.seq_len = params.seq_len;
+    l.h = l.out_h = params.h;
+    l.w = l.out_w = params.w;
+    l.c = l.out_c = params.c;
+    l.inputs = l.outputs = params.inputs;
+    //a [net] with only inputs= gives no shape, the inputs are normalized as one vector
+    if (l.h * l.w * l.c == 0) {
+      l.h = l.out_h = 1;
+      l.w = l.out_w = 1;
+      l.c = l.out_c = params.inputs;
+    }
 
     return l;
 }
@@ -336,12 +376,16 @@ layer parse_batchnorm(list *options, size_params params) {
 
 //@active, only sigmoid
 layer parse_activation(list *options, size_params params) {
-    layer l;
+    layer l = { (LAYER_TYPE)0 };
 
     l.type = ACTIVE;
+    l.seq_len = params.seq_len;
 
     l.inputs = params.inputs;
     l.outputs = l.inputs;
+    l.out_h = params.h;
+    l.out_w = params.w;
+    l.out_c = params.c;
 
     return l;
 }
@@ -349,19 +393,23 @@ layer parse_activation(list *options, size_params params) {
 
 //@relu
 layer parse_relu(list *options, size_params params) {
-    layer l;
+    layer l = { (LAYER_TYPE)0 };
 
     l.type = RELU;
+    l.seq_len = params.seq_len;
 
     l.inputs = params.inputs;
     l.outputs = l.inputs;
+    l.out_h = params.h;
+    l.out_w = params.w;
+    l.out_c = params.c;
 
     return l;
 }
 
 //@maxpool
 layer parse_maxpool(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
 
   l.type = MAXPOOL;
 
@@ -372,16 +420,19 @@ layer parse_maxpool(list *options, size_params params) {
   l.w = params.w;
   l.c = params.c;
 
-  l.out_h = (params.h - l.size) / l.stride + 1;
-  l.out_w = (params.w - l.size) / l.stride + 1;
+  l.pad = option_find_int_quiet(options, "pad", 0);
+  l.out_h = (params.h + 2 * l.pad - l.size) / l.stride + 1;
+  l.out_w = (params.w + 2 * l.pad - l.size) / l.stride + 1;
   l.out_c = params.c;
+  l.inputs = params.inputs;
+  l.outputs = l.out_h * l.out_w * l.out_c;
  
   return l;
 }
 
 //@avgpool
 layer parse_avgpool(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
 
   l.type = AVGPOOL;
 
@@ -392,9 +443,12 @@ layer parse_avgpool(list *options, size_params params) {
   l.w = params.w;
   l.c = params.c;
 
-  l.out_h = (params.h - l.size) / l.stride + 1;
-  l.out_w = (params.w - l.size) / l.stride + 1;
+  l.pad = option_find_int_quiet(options, "pad", 0);
+  l.out_h = (params.h + 2 * l.pad - l.size) / l.stride + 1;
+  l.out_w = (params.w + 2 * l.pad - l.size) / l.stride + 1;
   l.out_c = params.c;
+  l.inputs = params.inputs;
+  l.outputs = l.out_h * l.out_w * l.out_c;
  
   return l;
 }
@@ -402,14 +456,15 @@ layer parse_avgpool(list *options, size_params params) {
 
 //@lrn
 layer parse_lrn(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
   l.type = LRN;
 
   l.n = option_find_int_quiet(options, "n", 1);
 
-  l.h = params.h;
-  l.w = params.w;
-  l.c = params.c;
+  l.h = l.out_h = params.h;
+  l.w = l.out_w = params.w;
+  l.c = l.out_c = params.c;
+  l.inputs = l.outputs = params.inputs;
 
   return l;
 }
@@ -417,7 +472,7 @@ layer parse_lrn(list *options, size_params params) {
 
 //@deconv
 layer parse_deconv(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
 
   l.type = DECONV;
 
@@ -432,6 +487,8 @@ layer parse_deconv(list *options, size_params params) {
 
   l.h = (params.h - l.size) / l.stride + 1;
   l.w = (params.w - l.size) / l.stride + 1;
+  l.inputs = l.h * l.w * l.c;
+  l.outputs = l.out_h * l.out_w * l.out_c;
  
   return l;
 }
@@ -439,7 +496,7 @@ layer parse_deconv(list *options, size_params params) {
 
 //@unpool
 layer parse_unpool(list *options, size_params params) {
-  layer l;
+  layer l = { (LAYER_TYPE)0 };
 
   l.type = UNPOOL;
 
@@ -453,24 +510,220 @@ layer parse_unpool(list *options, size_params params) {
 
   l.h = (params.h - l.size) / l.stride + 1;
   l.w = (params.w - l.size) / l.stride + 1;
+  l.inputs = l.h * l.w * l.c;
+  l.outputs = l.out_h * l.out_w * l.out_c;
  
   return l;
 }
 
 
 
+//@shortcut, elementwise sum (or product, same cost) of the previous layer and layer from
+layer parse_shortcut(list *options, size_params params) {
+  layer l = { (LAYER_TYPE)0 };
+
+  l.type = SHORTCUT;
+  int from = option_find_int(options, "from", -1);
+  l.index = from < 0 ? params.index + from : from;
+  //the network input is index -1
+  if (l.index >= 0 && l.index < params.index && params.net.layers[l.index].outputs != params.inputs) {
+    fprintf(stderr, "shortcut from layer %d has %d outputs, layer %d has %d\n", l.index,
+        params.net.layers[l.index].outputs, params.index - 1, params.inputs);
+  }
+
+  l.seq_len = params.seq_len;
+  l.h = l.out_h = params.h;
+  l.w = l.out_w = params.w;
+  l.c = l.out_c = params.c;
+  l.inputs = l.outputs = params.inputs;
+
+  return l;
+}
+
+
+//@route, the next layer reads the output of an earlier one, no data moves
+layer parse_route(list *options, size_params params) {
+  layer l = { (LAYER_TYPE)0 };
+
+  l.type = ROUTE;
+  int index = option_find_int(options, "layers", -1);
+  l.index = index < 0 ? params.index + index : index;
+  if (l.index < 0 || l.index >= params.index) error("route must refer to an earlier layer");
+  layer *from = &params.net.layers[l.index];
+
+  l.seq_len = params.seq_len;
+  l.h = l.out_h = from->out_h;
+  l.w = l.out_w = from->out_w;
+  l.c = l.out_c = from->out_c;
+  l.inputs = l.outputs = from->outputs;
+
+  return l;
+}
+
+
+//@attention, scaled dot product over a fused q|k|v input of (heads + 2 kv_heads) x head_dim per token
+layer parse_attention(list *options, size_params params) {
+  layer l = { (LAYER_TYPE)0 };
+
+  l.type = ATTENTION;
+  l.heads = option_find_int_quiet(options, "heads", 1);
+  l.seq_len = params.seq_len;
+  //decoding one token against a cache of kv_len keys uses seq_len = 1
+  l.kv_len = option_find_int_quiet(options, "kv_len", params.seq_len);
+  l.kv_heads = option_find_int_quiet(options, "kv_heads", l.heads);
+  l.window = option_find_int_quiet(options, "window", 0);
+  l.flash = strcmp(option_find_str_quiet(options, "algo", "naive"), "flash") == 0;
+  if (l.kv_heads < 1 || l.heads % l.kv_heads) {
+    fprintf(stderr, "%d heads can't share %d kv heads, using %d\n", l.heads, l.kv_heads, l.heads);
+    l.kv_heads = l.heads;
+  }
+  int width = l.heads + 2 * l.kv_heads;
+  if (params.inputs % width) {
+    fprintf(stderr, "attention input %d isn't q|k|v of %d heads and %d kv heads\n", params.inputs, l.heads, l.kv_heads);
+  }
+
+  l.inputs = params.inputs;
+  l.c = params.inputs / width * l.heads;
+  l.h = l.w = 1;
+  l.out_h = l.out_w = 1;
+  l.out_c = l.c;
+  l.outputs = l.c;
+
+  return l;
+}
+
+
+
+//share of the routed tokens each expert gets: uniform, zipf with exponent s over the expert
+//index, or a histogram file of per expert counts separated by commas or lines
+float *routing_distribution(char *routing, float s, int experts) {
+  float *share = (float*)xcalloc(experts, sizeof(float));
+  int i, n = 0;
+  if (strcmp(routing, "uniform") == 0) {
+    for (i = 0; i < experts; ++i) share[i] = 1;
+  } else if (strcmp(routing, "zipf") == 0) {
+    for (i = 0; i < experts; ++i) share[i] = 1 / pow(i + 1, s);
+  } else {
+    FILE *fp = fopen(routing, "r");
+    if (!fp) file_error(routing);
+    char *line;
+    while ((line = fgetl(fp)) != 0) {
+      n += parse_float_list(line, share + n, experts - n);
+      free(line);
+    }
+    fclose(fp);
+    if (n < experts) {
+      fprintf(stderr, "%s has %d counts for %d experts\n", routing, n, experts);
+      error("moe routing histogram too short");
+    }
+  }
+  float sum = 0;
+  for (i = 0; i < experts; ++i) sum += share[i] > 0 ? share[i] : 0;
+  if (sum <= 0) error("moe routing without any tokens");
+  for (i = 0; i < experts; ++i) share[i] = share[i] > 0 ? share[i] / sum : 0;
+  return share;
+}
+
+//@moe, a gate routes each token to top_k of the experts, each an ffn of hidden units
+layer parse_moe(list *options, size_params params) {
+  layer l = { (LAYER_TYPE)0 };
+
+  l.type = MOE;
+  l.experts = option_find_int(options, "experts", 8);
+  if (l.experts < 1) l.experts = 1;
+  if (l.experts > MAX_EXPERTS) error("too many moe experts");
+  l.top_k = option_find_int_quiet(options, "top_k", 2);
+  if (l.top_k < 1) l.top_k = 1;
+  if (l.top_k > l.experts) l.top_k = l.experts;
+  l.hidden = option_find_int(options, "hidden", 4 * params.inputs);
+  l.gated = option_find_int_quiet(options, "gated", 0);
+  l.seq_len = params.seq_len;
+  float s = option_find_float_quiet(options, "zipf", 1);
+  l.routing = routing_distribution(option_find_str_quiet(options, "routing", "uniform"), s, l.experts);
+
+  l.inputs = params.inputs;
+  l.c = l.out_c = params.inputs;
+  l.h = l.w = 1;
+  l.out_h = l.out_w = 1;
+  l.outputs = params.inputs;
+
+  return l;
+}
+
+
+
+//@embedding, lookups rows of dim gathered from a table of vocab rows per sample, summed when pooled
+layer parse_embedding(list *options, size_params params) {
+  layer l = { (LAYER_TYPE)0 };
+
+  l.type = EMBEDDING;
+  l.vocab = option_find_int(options, "vocab", 1);
+  l.lookups = option_find_int_quiet(options, "lookups", 1);
+  if (l.lookups < 1) l.lookups = 1;
+  int dim = option_find_int(options, "dim", 1);
+  char *pool = option_find_str_quiet(options, "pool", "none");
+  l.pooled = strcmp(pool, "sum") == 0 || strcmp(pool, "mean") == 0;
+  l.cache = option_find_int_quiet(options, "cache", 0);
+  l.hit_rate = option_find_float_quiet(options, "hit_rate", -1);
+  if (l.hit_rate > 1) l.hit_rate = 1;
+  l.zipf = option_find_float_quiet(options, "zipf", 0);
+  l.seq_len = params.seq_len;
+
+  //the input is the row ids
+  l.inputs = l.lookups;
+  l.c = l.out_c = dim;
+  l.h = l.w = 1;
+  l.out_h = l.out_w = 1;
+  l.outputs = l.pooled ? dim : l.lookups * dim;
+
+  return l;
+}
+
+
+
 //=============================================================
 void parse_net_options(list *options, network *net) {
+  //an option named with a capital is a symbolic dimension and its default, e.g. S=128 or
+  //K=2*S over the ones before it
+  node *n;
+  for (n = options->front; n; n = n->next) {
+    kvp *p = (kvp *)n->val;
+    if (p->key[0] >= 'A' && p->key[0] <= 'Z') {
+      define_symbol(p->key, eval_dim(p->val));
+      p->used = 1;
+    }
+  }
+  net->batch = option_find_int_quiet(options, "batch",1);
+  if (net->batch < 1) net->batch = 1;
   net->h = option_find_int_quiet(options, "height",0);
   net->w = option_find_int_quiet(options, "width",0);
   net->c = option_find_int_quiet(options, "channels",0);
   net->inputs = option_find_int_quiet(options, "inputs",0);
+  if (!net->inputs) net->inputs = net->h * net->w * net->c;
   net->time_steps= option_find_int_quiet(options, "time_steps",0);
+  net->seq_len = option_find_int_quiet(options, "seq_len",1);
+  net->blocks = option_find_int_quiet(options, "blocks",1);
+  if (net->blocks < 1) net->blocks = 1;
+}
+
+void free_sections(list *sections) {
+  node *n;
+  for (n = sections->front; n; n = n->next) free_section((section *)n->val);
+  free_list(sections);
 }
 
 network parse_network_cfg(char *filename) {
   // 这里读取的文件应该是模型的配置文件
   list *sections = read_cfg(filename);
+  network net = parse_network_sections(sections);
+  free_sections(sections);
+  return net;
+}
+
+network parse_network_sections(list *sections) {
+  profile_begin(PROFILE_PARSE);
+  //the cfg's symbol defaults hold for this parse only
+  int symbols = save_symbols();
   node *n = sections->front;
   if(!n) error("Config file has no sections");
   network net = make_network(sections->size - 1);
@@ -480,11 +733,13 @@ network parse_network_cfg(char *filename) {
   list *options = s->options;
   parse_net_options(options, &net);
 
+  params.batch = net.batch;
   params.h = net.h;
   params.w = net.w;
   params.c = net.c;
   params.inputs = net.inputs;
   params.time_steps= net.time_steps;
+  params.seq_len = net.seq_len;
 
   int avg_outputs = 0;
   int avg_counter = 0;
@@ -493,9 +748,9 @@ network parse_network_cfg(char *filename) {
 
   n = n->next;
   int count = 0;
-  free_section(s);
   while(n){
     params.index = count;
+    params.net = net;
     s = (section *)n->val;
     options = s->options;
     layer l = { (LAYER_TYPE)0 };
@@ -524,15 +779,25 @@ network parse_network_cfg(char *filename) {
       l = parse_deconv(options, params);
     }else if (lt == UNPOOL) {
       l = parse_unpool(options, params);
+    }else if (lt == SHORTCUT) {
+      l = parse_shortcut(options, params);
+    }else if (lt == ROUTE) {
+      l = parse_route(options, params);
+    }else if (lt == ATTENTION) {
+      l = parse_attention(options, params);
+    }else if (lt == MOE) {
+      l = parse_moe(options, params);
+    }else if (lt == EMBEDDING) {
+      l = parse_embedding(options, params);
     }else{
       fprintf(stderr, "Type not recognized: %s\n", s->type);
     }
 
+    l.once = option_find_int_quiet(options, "once", 0);
     option_unused(options);
     net.layers[count] = l;
     if (l.inputs > max_inputs) max_inputs = l.inputs;
     if (l.outputs > max_outputs) max_outputs = l.outputs;
-    free_section(s);
     n = n->next;
     ++count;
     if(n){
@@ -555,14 +820,30 @@ network parse_network_cfg(char *filename) {
     }
   }
 
-  free_list(sections);
+  set_batch_network(&net, net.batch);
+  restore_symbols(symbols);
+  profile_end(PROFILE_PARSE);
 
   return net;
 }
 
 
+//a dvfs list of at most MAX_OPP points, a longer one is an error rather than cut short
+static int parse_opp_list(list *options, char *key, float *out) {
+  char *s = option_find_str_quiet(options, key, 0);
+  int n = s ? 1 : 0;
+  char *c;
+  for (c = s; c && *c; ++c) n += *c == ',';
+  if (n > MAX_OPP) {
+    fprintf(stderr, "%s has %d points, at most %d are supported\n", key, n, MAX_OPP);
+    error("too many dvfs operating points");
+  }
+  return parse_float_list(s, out, MAX_OPP);
+}
+
 //@hardware info
 void parse_hardware_cfg(char *filename, asic *hardware) {
+  profile_begin(PROFILE_PARSE);
   list *sections = read_cfg(filename);
   node *n = sections->front;
   if(!n) error("Config file has no sections");
@@ -571,6 +852,14 @@ void parse_hardware_cfg(char *filename, asic *hardware) {
   section *s = (section *)n->val;
   list *options = s->options;
   hardware->mac_num = option_find_int_quiet(options, "mac_num",1);
+  hardware->mac_rows = option_find_int_quiet(options, "mac_rows",0);
+  hardware->mac_cols = option_find_int_quiet(options, "mac_cols",0);
+  hardware->dataflow = get_dataflow(option_find_str_quiet(options, "dataflow", "weight_stationary"));
+  if (has_mac_array(hardware) && hardware->mac_rows * hardware->mac_cols != hardware->mac_num) {
+    fprintf(stderr, "mac_num %d doesn't match a %d x %d array, using %d\n", hardware->mac_num,
+        hardware->mac_rows, hardware->mac_cols, hardware->mac_rows * hardware->mac_cols);
+    hardware->mac_num = hardware->mac_rows * hardware->mac_cols;
+  }
   hardware->mac_dtype = option_find_int_quiet(options, "mac_dtype",1);
   hardware->mac_pipeline = option_find_int_quiet(options, "mac_pipeline",1);
   hardware->mac_stall_cycle = option_find_int_quiet(options, "mac_stall_cycle",0);
@@ -581,21 +870,109 @@ void parse_hardware_cfg(char *filename, asic *hardware) {
   hardware->vec_pipeline = option_find_int_quiet(options, "vec_pipeline",1);
   hardware->vec_stall_cycle = option_find_int_quiet(options, "vec_stall_cycle",0);
   hardware->pwr = option_find_float_quiet(options, "power",100000);
+  hardware->static_pwr = option_find_float_quiet(options, "static_power",0);
+  hardware->energy_mac_half = option_find_float_quiet(options, "energy_mac_half",0);
+  hardware->energy_mac_float = option_find_float_quiet(options, "energy_mac_float",0);
+  hardware->energy_vec = option_find_float_quiet(options, "energy_vec",0);
+  hardware->energy_surpass = option_find_float_quiet(options, "energy_surpass",0);
+  hardware->energy_sram = option_find_float_quiet(options, "energy_sram",0);
+  hardware->energy_dram = option_find_float_quiet(options, "energy_dram",0);
   hardware->area = option_find_float_quiet(options, "area",100000);
+  hardware->mac_area = option_find_float_quiet(options, "mac_area",0);
+  hardware->vec_area = option_find_float_quiet(options, "vec_area",0);
+  hardware->surpass_area = option_find_float_quiet(options, "surpass_area",0);
+  hardware->sram_area = option_find_float_quiet(options, "sram_area",0);
   hardware->off_bw = option_find_float_quiet(options, "offchip_bandwidth",0.0001);
   hardware->latency = option_find_float_quiet(options, "offchip_latency",0);
+  hardware->outstanding = option_find_int_quiet(options, "outstanding_requests",64);
+  if (hardware->outstanding < 1) hardware->outstanding = 1;
+  hardware->dma_num = option_find_int_quiet(options, "dma_num",1);
+  hardware->dram_channels = option_find_int_quiet(options, "dram_channels",1);
+  hardware->dram_burst = option_find_int_quiet(options, "dram_burst",64);
+  hardware->dram_page = option_find_int_quiet(options, "dram_page",0);
+  hardware->dram_banks = option_find_int_quiet(options, "dram_banks",8);
+  hardware->dram_row_miss = option_find_float_quiet(options, "dram_row_miss",30);
+  if (hardware->dram_burst < 1) hardware->dram_burst = 64;
+  if (hardware->dram_banks < 1) hardware->dram_banks = 1;
+  hardware->sram_size = option_find_int_quiet(options, "sram_size",2048);
+  hardware->tile_size = option_find_int_quiet(options, "tile_size",64);
+  if (hardware->dma_num < 1) hardware->dma_num = 1;
+  if (hardware->dram_channels < 1) hardware->dram_channels = 1;
+  if (2 * hardware->tile_size > hardware->sram_size) {
+    fprintf(stderr, "tile_size %d KB doesn't double buffer in %d KB of sram, using %d KB\n",
+        hardware->tile_size, hardware->sram_size, hardware->sram_size / 2);
+    hardware->tile_size = hardware->sram_size / 2;
+  }
+  if (hardware->tile_size < 1) hardware->tile_size = 1;
+  hardware->prefetch_size = option_find_int_quiet(options, "prefetch_buffer",hardware->sram_size / 2);
+  if (hardware->prefetch_size < 0) hardware->prefetch_size = 0;
   hardware->freq = option_find_float_quiet(options, "frequency",1);
+
+  //dvfs operating points and thermal model
+  hardware->opp_num = parse_opp_list(options, "dvfs_frequency", hardware->opp_freq);
+  if (hardware->opp_num > 0) {
+    int nv = parse_opp_list(options, "dvfs_voltage", hardware->opp_volt);
+    int np = parse_opp_list(options, "dvfs_power", hardware->opp_pwr);
+    int k;
+    if (nv != hardware->opp_num) error("dvfs_voltage needs one voltage per dvfs_frequency");
+    if (np != 0 && np != hardware->opp_num) error("dvfs_power needs one power per dvfs_frequency");
+    if (np == 0) for (k = 0; k < hardware->opp_num; ++k) hardware->opp_pwr[k] = 0;
+  }
+  float vmax = 1;
+  int k;
+  for (k = 0; k < hardware->opp_num; ++k) {
+    if (hardware->opp_volt[k] <= 0) error("dvfs_voltage must be positive");
+    if (k == 0 || hardware->opp_volt[k] > vmax) vmax = hardware->opp_volt[k];
+  }
+  hardware->volt = option_find_float_quiet(options, "voltage", vmax);
+  if (hardware->volt <= 0) error("voltage must be positive");
+  hardware->tdp = option_find_float_quiet(options, "tdp", 0);
+  hardware->thermal_res = option_find_float_quiet(options, "thermal_resistance", 0);
+  hardware->thermal_tau = option_find_float_quiet(options, "thermal_tau", 1);
+  hardware->ambient = option_find_float_quiet(options, "ambient_temperature", 25);
+  hardware->max_temp = option_find_float_quiet(options, "max_temperature", 100);
   hardware->ave_alu_eff = option_find_float_quiet(options, "average_alu_efficiency",100);
   hardware->ave_bw_eff = option_find_float_quiet(options, "average_bandwidth_efficiency",100);
   hardware->surpass_eff = option_find_float_quiet(options, "surpass_efficiency",100);
+  //per layer type efficiencies, e.g. from calibration: convolutional_efficiency = 85
+  int t;
+  for (t = 0; t <= BLANK; ++t) {
+    char key[64];
+    hardware->type_eff[t] = 0;
+    if (strcmp(get_layer_string((LAYER_TYPE)t), "none") == 0) continue;
+    sprintf(key, "%s_efficiency", get_layer_string((LAYER_TYPE)t));
+    hardware->type_eff[t] = option_find_float_quiet(options, key, 0);
+  }
+
+  //memory tiers, e.g. [tier] name=hbm capacity=4096 bandwidth=400 latency=0.1 energy=4
+  hardware->tier_num = 0;
+  for (n = n->next; n; n = n->next) {
+    s = (section *)n->val;
+    if (strcmp(s->type, "[tier]") != 0) {
+      fprintf(stderr, "Type not recognized: %s\n", s->type);
+      continue;
+    }
+    if (hardware->tier_num == MAX_TIERS) error("too many memory tiers");
+    memory_tier *tier = &hardware->tiers[hardware->tier_num++];
+    options = s->options;
+    memset(tier->name, 0, sizeof(tier->name));
+    strncpy(tier->name, option_find_str(options, "name", "tier"), sizeof(tier->name) - 1);
+    tier->capacity = option_find_float(options, "capacity", 0);
+    tier->bw = option_find_float(options, "bandwidth", hardware->off_bw);
+    tier->latency = option_find_float_quiet(options, "latency", hardware->latency);
+    tier->energy = option_find_float_quiet(options, "energy", hardware->energy_dram);
+    if (tier->bw <= 0) error("a memory tier needs a bandwidth");
+  }
 
   free_list(sections);
+  profile_end(PROFILE_PARSE);
 }
 
 
 list *read_cfg(char *filename) {
   FILE *file = fopen(filename, "r");
   if(file == 0) file_error(filename);
+  profile_begin(PROFILE_READ_CFG);
   char *line;
   int nu = 0;
   list *sections = make_list();
@@ -624,5 +1001,6 @@ list *read_cfg(char *filename) {
     }
   }
   fclose(file);
+  profile_end(PROFILE_READ_CFG);
   return sections;
 }
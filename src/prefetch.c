@@ -0,0 +1,141 @@
+#include <stdlib.h>
+
+#include "prefetch.h"
+#include "cost.h"
+#include "network.h"
+#include "utils.h"
+
+#define PREFETCH_TOP 10
+
+//a layer's weight bytes and the time each of them takes at the layer's achieved bandwidth
+static float weight_bytes(layer_cost *c) {
+  return c->mem_weight < c->mem ? c->mem_weight : c->mem;
+}
+
+static float byte_time(layer_cost *c) {
+  return c->mem > 0 ? c->mem_perf / c->mem : 0;
+}
+
+/* the dma engine serves the running layer first, its activations and the weights that
+   weren't prefetched, and spends the rest of the layer's compute time fetching the next
+   layers' weights in order into the buffer; a layer's prefetched bytes stay in the buffer
+   until it ends, so the running layer's share isn't free for the ones after it */
+float prefetch_network(asic *hardware, network *net, float buffer, prefetch_layer *layers) {
+  int n = net->n;
+  layer_cost *c = (layer_cost*)xcalloc(n > 0 ? n : 1, sizeof(layer_cost));
+  float *prefetched = (float*)xcalloc(n > 0 ? n : 1, sizeof(float));
+  float now = 0;
+  int i, next = 0;
+  for (i = 0; i < n; ++i) c[i] = cost_layer(hardware, &net->layers[i]);
+  for (i = 0; i < n; ++i) {
+    float weights = weight_bytes(&c[i]);
+    //streaming what wasn't prefetched costs the same per byte as in isolation
+    float own = c[i].mem_perf - prefetched[i] * byte_time(&c[i]);
+    float end = now + (c[i].alu_perf > own ? c[i].alu_perf : own);
+    if (layers) {
+      layers[i].start = now;
+      layers[i].end = end;
+      layers[i].compute = c[i].alu_perf;
+      layers[i].load = weights * byte_time(&c[i]);
+      layers[i].prefetched = prefetched[i];
+      layers[i].stall = own > c[i].alu_perf ? own - c[i].alu_perf : 0;
+    }
+
+    //idle dma time while layer i computes goes to the layers after it
+    float idle = c[i].alu_perf - own;
+    float used = 0;
+    int j;
+    for (j = i; j < n; ++j) used += prefetched[j];
+    if (next <= i) next = i + 1;
+    while (idle > 0 && next < n && used < buffer) {
+      float t = byte_time(&c[next]);
+      float want = weight_bytes(&c[next]) - prefetched[next];
+      if (want > buffer - used) want = buffer - used;
+      if (t > 0 && want * t > idle) want = idle / t;
+      prefetched[next] += want;
+      used += want;
+      idle -= want * t;
+      if (prefetched[next] < weight_bytes(&c[next])) break;
+      ++next;
+    }
+    now = end;
+  }
+  free(c);
+  free(prefetched);
+  return now;
+}
+
+static prefetch_layer *sorted_layers;
+static int by_stall(const void *a, const void *b) {
+  float x = sorted_layers[*(int*)a].stall, y = sorted_layers[*(int*)b].stall;
+  if (x != y) return x > y ? -1 : 1;
+  return *(int*)a - *(int*)b;
+}
+
+void prefetch_report(asic *hardware, network *net) {
+  int n = net->n;
+  int i;
+  float buffer = hardware->prefetch_size * 1024.0;
+  prefetch_layer *layers = (prefetch_layer*)xcalloc(n > 0 ? n : 1, sizeof(prefetch_layer));
+  float isolated = prefetch_network(hardware, net, 0, 0);
+  float pipelined = prefetch_network(hardware, net, buffer, layers);
+
+  //the timeline is one pass over the layers, so are the bounds
+  float load = 0, hidden = isolated - pipelined, alu = 0, mem = 0;
+  int stalls = 0;
+  for (i = 0; i < n; ++i) {
+    layer_cost c = cost_layer(hardware, &net->layers[i]);
+    load += layers[i].load;
+    alu += c.alu_perf;
+    mem += c.mem_perf;
+  }
+
+  printf("===========weight prefetch================\n");
+  if (net->blocks > 1) printf("Blocks                 : %d (one block is simulated)\n", net->blocks);
+  printf("Prefetch Buffer        : %d KB\n", hardware->prefetch_size);
+  printf("Layer By Layer         : %.5f us (each layer overlaps only its own loads)\n", isolated);
+  printf("Prefetched             : %.5f us\n", pipelined);
+  printf("Overlapped Bound       : %.5f us\n", alu > mem ? alu : mem);
+  printf("Serial Bound           : %.5f us\n", alu + mem);
+  printf("Weight Load            : %.5f us\n", load);
+  printf("Hidden By Prefetch     : %.5f us (%.2f%% of the weight load)\n", hidden, load > 0 ? 100 * hidden / load : 0);
+  printf("Speedup                : %.3fx\n", pipelined > 0 ? isolated / pipelined : 0);
+
+  printf("\n%5s  %-15s  %12s  %12s  %12s  %10s  %12s\n", "Layer", "Type", "Compute(us)", "Weights(us)",
+      "Prefetch(KB)", "Prefetch(%)", "Stall(us)");
+  for (i = 0; i < n; ++i) {
+    prefetch_layer *p = &layers[i];
+    layer_cost c = cost_layer(hardware, &net->layers[i]);
+    float weights = c.mem_weight < c.mem ? c.mem_weight : c.mem;
+    if (p->stall > 0) ++stalls;
+    if (weights <= 0) continue;
+    printf("%5d  %-15s  %12.5f  %12.5f  %12.1f  %10.2f  %12.5f\n", i, get_layer_string(net->layers[i].type),
+        p->compute, p->load, p->prefetched / 1024, 100 * p->prefetched / weights, p->stall);
+  }
+
+  //what still waits on memory, longest first
+  int *order = (int*)xcalloc(n > 0 ? n : 1, sizeof(int));
+  for (i = 0; i < n; ++i) order[i] = i;
+  sorted_layers = layers;
+  qsort(order, n, sizeof(int), by_stall);
+  printf("\nStalling Layers        : %d of %d\n", stalls, n);
+  if (stalls > 0) {
+    printf("%5s  %-15s  %12s  %10s\n", "Layer", "Type", "Stall(us)", "Share(%)");
+    for (i = 0; i < PREFETCH_TOP && i < n && layers[order[i]].stall > 0; ++i) {
+      int l = order[i];
+      printf("%5d  %-15s  %12.5f  %10.2f\n", l, get_layer_string(net->layers[l].type), layers[l].stall,
+          pipelined > 0 ? 100 * layers[l].stall / pipelined : 0);
+    }
+  }
+
+  //how the latency moves with the buffer
+  printf("\n%12s  %14s  %10s\n", "Buffer(KB)", "Latency(us)", "Speedup");
+  int kb = hardware->prefetch_size / 8 > 0 ? hardware->prefetch_size / 8 : 1;
+  for (; kb <= hardware->prefetch_size * 8; kb *= 2) {
+    float t = prefetch_network(hardware, net, kb * 1024.0, 0);
+    printf("%12d  %14.5f  %10.3f\n", kb, t, t > 0 ? isolated / t : 0);
+  }
+  printf("===========weight prefetch================\n\n\n");
+  free(order);
+  free(layers);
+}
@@ -0,0 +1,69 @@
+#include "profile.h"
+#include "utils.h"
+
+profile prof = {0};
+__thread profile_counters prof_count = {0};
+
+static char *get_phase_string(PROFILE_PHASE p) {
+  switch(p) {
+    case PROFILE_PARSE:
+      return "Parsing";
+    case PROFILE_READ_CFG:
+      return "  read_cfg/fgetl";
+    case PROFILE_OPTIONS:
+      return "  option lookup";
+    case PROFILE_COST:
+      return "Layer loop";
+    case PROFILE_ENGINE:
+      return "Event simulation";
+    case PROFILE_ANALYSIS:
+      return "Analyses";
+    case PROFILE_OUTPUT:
+      return "Output";
+    default:
+      break;
+  }
+  return "none";
+}
+
+void enable_profile() {
+  prof.enabled = 1;
+  prof.begin = what_time_is_it_now();
+}
+
+void profile_begin(PROFILE_PHASE p) {
+  if (!prof.enabled) return;
+  prof.start[p] = what_time_is_it_now();
+}
+
+void profile_end(PROFILE_PHASE p) {
+  if (!prof.enabled) return;
+  prof.total[p] += what_time_is_it_now() - prof.start[p];
+  ++prof.calls[p];
+}
+
+void profile_add(profile_counters *c) {
+  prof_count.allocations += c->allocations;
+  prof_count.allocated += c->allocated;
+  prof_count.layers += c->layers;
+  prof_count.networks += c->networks;
+}
+
+void print_profile() {
+  double wall = what_time_is_it_now() - prof.begin;
+  int p;
+  fprintf(stderr, "===========simulator stats================\n");
+  fprintf(stderr, "Phase                   Time(ms)      Calls\n");
+  for (p = 0; p < NUM_PROFILE_PHASES; ++p) {
+    fprintf(stderr, "%-20s  %10.3f  %9ld\n", get_phase_string((PROFILE_PHASE)p), prof.total[p] * 1000, prof.calls[p]);
+  }
+  fprintf(stderr, "Wall Time              : %.3f ms\n", wall * 1000);
+  fprintf(stderr, "Allocations            : %ld (%.3f MB)\n", prof_count.allocations, prof_count.allocated / (1024.0 * 1024));
+  fprintf(stderr, "Layers Evaluated       : %ld\n", prof_count.layers);
+  fprintf(stderr, "Networks Evaluated     : %ld\n", prof_count.networks);
+  fprintf(stderr, "Evaluations Per Second : %.0f layers/s over the run\n", wall > 0 ? prof_count.layers / wall : 0);
+  if (prof.total[PROFILE_COST] > 0) {
+    fprintf(stderr, "Layer Loop Throughput  : %.0f layers/s\n", prof.calls[PROFILE_COST] / prof.total[PROFILE_COST]);
+  }
+  fprintf(stderr, "===========simulator stats================\n");
+}
@@ -0,0 +1,174 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "sensitivity.h"
+#include "cost.h"
+#include "dram.h"
+#include "energy.h"
+#include "mapping.h"
+#include "network.h"
+#include "sweep.h"
+#include "utils.h"
+
+//a hardware field and the area one more unit of it costs
+typedef struct knob {
+    char *key;
+    float value;
+    float area;                 //mm^2 per unit, 0 when unknown
+    float d_latency;            //per unit of the field
+    float d_energy;
+    float *d_layer;             //per layer latency derivative
+} knob;
+
+static void add_knob(knob *k, int *n, char *key, asic *hardware, float area) {
+  k[*n].key = key;
+  k[*n].value = get_hardware_field(hardware, key, 0);
+  k[*n].area = area;
+  ++*n;
+}
+
+//end to end latency and energy as cost_network computes them, plus each layer's roofline latency over
+//all the blocks it runs in
+static void evaluate(asic *a, network *net, float *layer_times, float *latency, float *energy) {
+  float alu = 0, mem = 0, dynamic = 0;
+  int i;
+  for (i = 0; i < net->n; ++i) {
+    layer_cost c = cost_layer(a, &net->layers[i]);
+    float r = layer_repeats(net, &net->layers[i]);
+    layer_times[i] = r * layer_latency(&c);
+    alu += r * c.alu_perf;
+    mem += r * c.mem_perf;
+    dynamic += r * c.energy;
+  }
+  *latency = alu > mem ? alu : mem;
+  if (has_energy_model(a)) *energy = dynamic + static_energy(a, *latency);
+  else *energy = a->pwr * *latency;
+}
+
+/* central difference through the full cost model; integer fields take one more unit, the
+   marginal value of the next alu or KB, since one less can straddle a mapping cliff */
+static void differentiate(asic *hardware, network *net, knob *k, float *up_layer, float *down_layer) {
+  asic up = *hardware, down = *hardware;
+  int is_int;
+  float x = get_hardware_field(hardware, k->key, &is_int);
+  float hi, lo;
+  if (is_int) {
+    hi = x + 1;
+    lo = x;
+  } else {
+    float h = fabs(x) > 0 ? 1e-3 * fabs(x) : 1e-3;
+    hi = x + h;
+    lo = x - h;
+  }
+  set_hardware_field(&up, k->key, hi);
+  set_hardware_field(&down, k->key, lo);
+  float t_up, t_down, e_up, e_down;
+  evaluate(&up, net, up_layer, &t_up, &e_up);
+  evaluate(&down, net, down_layer, &t_down, &e_down);
+  k->d_latency = (t_up - t_down) / (hi - lo);
+  k->d_energy = (e_up - e_down) / (hi - lo);
+  k->d_layer = (float*)xcalloc(net->n, sizeof(float));
+  int i;
+  for (i = 0; i < net->n; ++i) k->d_layer[i] = (up_layer[i] - down_layer[i]) / (hi - lo);
+}
+
+static float elasticity(float d, float x, float y) {
+  return y > 0 ? d * x / y : 0;
+}
+
+static float *sorted_d;
+static int by_gain(const void *a, const void *b) {
+  float da = sorted_d[*(int*)a], db = sorted_d[*(int*)b];
+  if (da != db) return da < db ? -1 : 1;
+  return *(int*)a - *(int*)b;
+}
+
+void sensitivity_report(asic *hardware, network *net) {
+  knob knobs[MAX_KNOBS];
+  int n = 0;
+  int i, j;
+  if (has_mac_array(hardware)) {
+    add_knob(knobs, &n, "mac_rows", hardware, hardware->mac_area * hardware->mac_cols);
+    add_knob(knobs, &n, "mac_cols", hardware, hardware->mac_area * hardware->mac_rows);
+  } else {
+    add_knob(knobs, &n, "mac_num", hardware, hardware->mac_area);
+  }
+  add_knob(knobs, &n, "vec_num", hardware, hardware->vec_area);
+  if (hardware->surpass_num > 0) add_knob(knobs, &n, "surpass_num", hardware, hardware->surpass_area);
+  add_knob(knobs, &n, "offchip_bandwidth", hardware, 0);
+  add_knob(knobs, &n, "frequency", hardware, 0);
+  add_knob(knobs, &n, "average_alu_efficiency", hardware, 0);
+  add_knob(knobs, &n, "average_bandwidth_efficiency", hardware, 0);
+  if (hardware->surpass_num > 0) add_knob(knobs, &n, "surpass_efficiency", hardware, 0);
+  add_knob(knobs, &n, "sram_size", hardware, hardware->sram_area);
+  if (has_dram_model(hardware)) add_knob(knobs, &n, "dram_channels", hardware, 0);
+
+  float *base_layer = (float*)xcalloc(net->n, sizeof(float));
+  float *up_layer = (float*)xcalloc(net->n, sizeof(float));
+  float *down_layer = (float*)xcalloc(net->n, sizeof(float));
+  float latency, energy;
+  evaluate(hardware, net, base_layer, &latency, &energy);
+  for (j = 0; j < n; ++j) differentiate(hardware, net, &knobs[j], up_layer, down_layer);
+
+  printf("===========sensitivity====================\n");
+  printf("Latency                : %.5f us\n", latency);
+  printf("Energy                 : %.5f uJ\n\n", energy);
+  printf("%-28s  %10s  %14s  %10s  %14s  %10s  %12s\n", "Field", "Value", "dLatency/dx", "Elasticity",
+      "dEnergy/dx", "Elasticity", "us per mm^2");
+  int best = -1;
+  for (j = 0; j < n; ++j) {
+    knob *k = &knobs[j];
+    printf("%-28s  %10g  %14.6g  %10.4f  %14.6g  %10.4f", k->key, k->value, k->d_latency,
+        elasticity(k->d_latency, k->value, latency), k->d_energy, elasticity(k->d_energy, k->value, energy));
+    if (k->area > 0) {
+      //latency saved by the area one more unit costs
+      printf("  %12.6g\n", k->d_latency != 0 ? -k->d_latency / k->area : 0);
+      if (best < 0 || -k->d_latency / k->area > -knobs[best].d_latency / knobs[best].area) best = j;
+    } else {
+      printf("  %12s\n", "-");
+    }
+  }
+  if (best >= 0 && knobs[best].d_latency < 0) {
+    printf("\nBest Use Of Area       : %s (%.6g us per mm^2)\n", knobs[best].key, -knobs[best].d_latency / knobs[best].area);
+  }
+
+  //each layer's lever: the field whose relative change helps its own roofline latency most
+  int *levers = (int*)xcalloc(n, sizeof(int));
+  for (i = 0; i < net->n; ++i) {
+    int lever = -1;
+    float most = 0;
+    for (j = 0; j < n; ++j) {
+      float e = -elasticity(knobs[j].d_layer[i], knobs[j].value, base_layer[i]);
+      if (e > most) most = e, lever = j;
+    }
+    if (lever >= 0) ++levers[lever];
+  }
+  printf("\n%-28s  %10s\n", "Field", "Layers");
+  for (j = 0; j < n; ++j) {
+    if (levers[j] > 0) printf("%-28s  %10d\n", knobs[j].key, levers[j]);
+  }
+
+  int *order = (int*)xcalloc(net->n, sizeof(int));
+  for (j = 0; j < n; ++j) {
+    knob *k = &knobs[j];
+    for (i = 0; i < net->n; ++i) order[i] = i;
+    sorted_d = k->d_layer;
+    qsort(order, net->n, sizeof(int), by_gain);
+    if (net->n == 0 || k->d_layer[order[0]] >= 0) continue;
+    printf("\nLayers helped most by %s:\n", k->key);
+    printf("%5s  %-15s  %14s  %10s\n", "Layer", "Type", "dLatency/dx", "Elasticity");
+    for (i = 0; i < SENSITIVITY_TOP && i < net->n && k->d_layer[order[i]] < 0; ++i) {
+      int l = order[i];
+      printf("%5d  %-15s  %14.6g  %10.4f\n", l, get_layer_string(net->layers[l].type), k->d_layer[l],
+          elasticity(k->d_layer[l], k->value, base_layer[l]));
+    }
+  }
+  printf("===========sensitivity====================\n\n\n");
+
+  for (j = 0; j < n; ++j) free(knobs[j].d_layer);
+  free(order);
+  free(levers);
+  free(base_layer);
+  free(up_layer);
+  free(down_layer);
+}
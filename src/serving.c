@@ -0,0 +1,230 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serving.h"
+#include "cost.h"
+#include "network.h"
+#include "utils.h"
+
+BATCH_POLICY get_batch_policy(char *s) {
+  if (strcmp(s, "static") == 0) return STATIC_BATCH;
+  if (strcmp(s, "dynamic") == 0) return DYNAMIC_BATCH;
+  if (strcmp(s, "continuous") == 0) return CONTINUOUS_BATCH;
+  fprintf(stderr, "Couldn't find batch policy %s, going with dynamic\n", s);
+  return DYNAMIC_BATCH;
+}
+
+char *get_batch_policy_string(BATCH_POLICY p) {
+  switch(p) {
+    case STATIC_BATCH:
+      return "static";
+    case DYNAMIC_BATCH:
+      return "dynamic";
+    case CONTINUOUS_BATCH:
+      return "continuous";
+  }
+  return "none";
+}
+
+static int arrival_comparator(const void *a, const void *b) {
+  double x = ((request*)a)->arrival;
+  double y = ((request*)b)->arrival;
+  return (x > y) - (x < y);
+}
+
+request *read_arrivals(char *filename, int *n) {
+  FILE *file = fopen(filename, "r");
+  if (file == 0) file_error(filename);
+  int size = 1024;
+  request *r = (request*)xcalloc(size, sizeof(request));
+  char *line;
+  *n = 0;
+  while ((line = fgetl(file)) != 0) {
+    double t;
+    int length = 1;
+    strip(line);
+    if (line[0] != '#' && sscanf(line, "%lf,%d", &t, &length) >= 1) {
+      if (*n == size) {
+        size *= 2;
+        r = (request*)xrealloc(r, size * sizeof(request));
+      }
+      r[*n].arrival = t;
+      r[*n].length = length > 0 ? length : 1;
+      r[*n].finish = 0;
+      ++*n;
+    }
+    free(line);
+  }
+  fclose(file);
+  qsort(r, *n, sizeof(request), arrival_comparator);
+  return r;
+}
+
+request *poisson_arrivals(int n, float rate, int length, unsigned int seed) {
+  request *r = (request*)xcalloc(n, sizeof(request));
+  double t = 0;
+  int i;
+  srand(seed);
+  for (i = 0; i < n; ++i) {
+    //exponential inter-arrival times, u in (0, 1]
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 1.0);
+    t += -log(u) / rate * 1000 * 1000;
+    r[i].arrival = t;
+    r[i].length = length;
+  }
+  return r;
+}
+
+//one iteration of the network at every batch size, lat[b] in us
+static double *batch_latency(asic *hardware, network *net, int max_batch) {
+  double *lat = (double*)xcalloc(max_batch + 1, sizeof(double));
+  int batch = net->batch;
+  int b;
+  for (b = 1; b <= max_batch; ++b) {
+    set_batch_network(net, b);
+    lat[b] = cost_network(hardware, net).peak_perf;
+  }
+  set_batch_network(net, batch);
+  return lat;
+}
+
+//batches are launched whole, a static batch waits for max_batch requests (the tail of the
+//trace runs short) and a dynamic one until it's full or its oldest request timed out;
+//every request of a batch runs as many iterations as the longest one
+static double run_batches(request *r, int n, double *lat, serving_config *cfg, long *batches) {
+  double now = 0;
+  double busy = 0;
+  int head = 0;
+  while (head < n) {
+    int full = head + cfg->max_batch < n ? head + cfg->max_batch : n;
+    double launch = r[full - 1].arrival;
+    if (cfg->policy == DYNAMIC_BATCH && r[head].arrival + cfg->timeout < launch) {
+      launch = r[head].arrival + cfg->timeout;
+    }
+    if (launch < now) launch = now;
+    int end = head;
+    int length = 0;
+    while (end < full && r[end].arrival <= launch) {
+      if (r[end].length > length) length = r[end].length;
+      ++end;
+    }
+    int b = cfg->policy == STATIC_BATCH ? cfg->max_batch : end - head;
+    now = launch + length * lat[b];
+    busy += length * lat[b];
+    for (; head < end; ++head) r[head].finish = now;
+    ++*batches;
+  }
+  return busy;
+}
+
+//continuous batching: requests join and leave between iterations
+static double run_continuous(request *r, int n, double *lat, serving_config *cfg, long *batches) {
+  int *active = (int*)xcalloc(cfg->max_batch, sizeof(int));
+  int *left = (int*)xcalloc(cfg->max_batch, sizeof(int));
+  int nactive = 0;
+  int next = 0;
+  int done = 0;
+  double now = 0;
+  double busy = 0;
+  while (done < n) {
+    if (nactive == 0 && r[next].arrival > now) now = r[next].arrival;
+    while (next < n && nactive < cfg->max_batch && r[next].arrival <= now) {
+      active[nactive] = next;
+      left[nactive] = r[next].length;
+      ++nactive;
+      ++next;
+    }
+    now += lat[nactive];
+    busy += lat[nactive];
+    ++*batches;
+    int i = 0;
+    while (i < nactive) {
+      if (--left[i] == 0) {
+        r[active[i]].finish = now;
+        ++done;
+        --nactive;
+        active[i] = active[nactive];
+        left[i] = left[nactive];
+      } else {
+        ++i;
+      }
+    }
+  }
+  free(active);
+  free(left);
+  return busy;
+}
+
+static int double_comparator(const void *a, const void *b) {
+  double x = *(double*)a;
+  double y = *(double*)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(double *sorted, int n, float p) {
+  int i = (int)ceil(p / 100 * n) - 1;
+  if (i < 0) i = 0;
+  if (i >= n) i = n - 1;
+  return sorted[i];
+}
+
+void serving_report(asic *hardware, network *net, serving_config *cfg) {
+  int n = cfg->requests;
+  request *r = cfg->arrivals ? read_arrivals(cfg->arrivals, &n)
+                             : poisson_arrivals(n, cfg->rate, cfg->length, cfg->seed);
+  if (n == 0) {
+    fprintf(stderr, "No requests to serve\n");
+    free(r);
+    return;
+  }
+  if (cfg->max_batch < 1) cfg->max_batch = 1;
+  double *lat = batch_latency(hardware, net, cfg->max_batch);
+
+  long batches = 0;
+  double busy = cfg->policy == CONTINUOUS_BATCH ? run_continuous(r, n, lat, cfg, &batches)
+                                                : run_batches(r, n, lat, cfg, &batches);
+
+  double *latency = (double*)xcalloc(n, sizeof(double));
+  double sum = 0;
+  double last = 0;
+  long iterations = 0;
+  int i;
+  for (i = 0; i < n; ++i) {
+    latency[i] = r[i].finish - r[i].arrival;
+    sum += latency[i];
+    iterations += r[i].length;
+    if (r[i].finish > last) last = r[i].finish;
+  }
+  qsort(latency, n, sizeof(double), double_comparator);
+  double span = last - r[0].arrival;
+  double window = r[n-1].arrival - r[0].arrival;
+
+  printf("===========serving========================\n");
+  printf("Batch Policy           : %s\n", get_batch_policy_string(cfg->policy));
+  printf("Max Batch              : %d\n", cfg->max_batch);
+  if (cfg->policy == DYNAMIC_BATCH) printf("Batch Timeout          : %.5f us\n", cfg->timeout);
+  if (cfg->arrivals) {
+    printf("Arrivals               : %s\n", cfg->arrivals);
+  } else {
+    printf("Arrivals               : poisson, %.5f requests/s\n", cfg->rate);
+  }
+  printf("Requests               : %d (%.2f iterations each)\n", n, (double)iterations / n);
+  printf("Iteration Latency      : %.5f us at batch 1, %.5f us at batch %d\n",
+      lat[1], lat[cfg->max_batch], cfg->max_batch);
+  printf("Offered Load           : %.5f requests/s\n", window > 0 ? (n - 1) / window * 1e6 : 0);
+  printf("Sustained QPS          : %.5f\n", span > 0 ? n / span * 1e6 : 0);
+  printf("Mean Latency           : %.5f us\n", sum / n);
+  printf("P50 Latency            : %.5f us\n", percentile(latency, n, 50));
+  printf("P99 Latency            : %.5f us\n", percentile(latency, n, 99));
+  printf("P999 Latency           : %.5f us\n", percentile(latency, n, 99.9));
+  printf("Max Latency            : %.5f us\n", latency[n-1]);
+  printf("Mean Batch             : %.3f\n", cfg->policy == CONTINUOUS_BATCH ?
+      (double)iterations / batches : (double)n / batches);
+  printf("Asic Busy              : %.3f%%\n", span > 0 ? 100 * busy / span : 0);
+  printf("===========serving========================\n\n\n");
+
+  free(latency);
+  free(lat);
+  free(r);
+}
@@ -3,27 +3,156 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #if defined(_MSC_VER) && defined(_DEBUG)
 #include <crtdbg.h>
 #endif
 
 #include "parser.h"
+#include "option.h"
 #include "utils.h"
+#include "network.h"
+#include "cost.h"
+#include "mapping.h"
+#include "dram.h"
+#include "energy.h"
+#include "engine.h"
+#include "trace.h"
+#include "dvfs.h"
+#include "serving.h"
+#include "colocate.h"
+#include "autotune.h"
+#include "calibrate.h"
+#include "profile.h"
+#include "sweep.h"
+#include "sensitivity.h"
+#include "dims.h"
+#include "attention.h"
+#include "moe.h"
+#include "speculative.h"
+#include "train.h"
+#include "tiers.h"
+#include "prefetch.h"
+#include "conv.h"
+
+//convolutions the cfg pins to an algorithm the mac precision can't run accurately
+void warn_inexact_convs(asic *hardware, network *net) {
+  int i;
+  for (i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if (l->type != CONVOLUTIONAL || l->conv_algo == CONV_AUTO) continue;
+    if (conv_algo_exact(hardware, (CONV_ALGO)l->conv_algo)) continue;
+    fprintf(stderr, "layer %d: %s is inexact with half precision macs, auto and --tune leave it out\n", i,
+        get_conv_string((CONV_ALGO)l->conv_algo));
+  }
+}
+
+//steps of a recurrent layer run one after another, each bound by its compute or by the
+//recurrent weights that didn't fit on chip
+void print_recurrent(asic *hardware, network *net) {
+  int i, any = 0;
+  for(i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if(l->type != RNN && l->type != LSTM) continue;
+    if(!any) {
+      printf("===========recurrent======================\n");
+      printf("Layer  Type   Steps  Recurrent(KB)  Resident(%%)      Step(us)  Sequence(us)  Bound\n");
+      any = 1;
+    }
+    layer_cost c = cost_layer(hardware, l);
+    int steps = l->n > 0 ? l->n : 1;
+    float recurrent = recurrent_weight_bytes(hardware, l);
+    float resident = resident_weight_bytes(hardware, l);
+    float seq = layer_latency(&c);
+    printf("%5d  %-5s  %5d  %13.1f  %11.1f  %12.5f  %12.5f  %s\n", i, get_layer_string(l->type), steps,
+        recurrent / 1024, recurrent > 0 ? 100 * resident / recurrent : 100, seq / steps, seq,
+        c.alu_perf > c.mem_perf ? "compute" : "memory");
+  }
+  if(any) printf("===========recurrent======================\n\n\n");
+}
+
+//attention with shared kv heads or a window, against full multi-head attention of the same
+//width and its q|k|v projection
+void print_kv_cache(asic *hardware, network *net) {
+  int i, any = 0;
+  float saved = 0;
+  for(i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if(l->type != ATTENTION || (l->kv_heads == l->heads && l->window <= 0)) continue;
+    if(!any) {
+      printf("===========kv cache=======================\n");
+      printf("Layer  Heads  KV Heads  Window    Cache(MB)  MHA Cache(MB)   Data(MB)  MHA Data(MB)  Saved(%%)   Latency(us)       MHA(us)\n");
+      any = 1;
+    }
+    layer mha = *l;
+    mha.kv_heads = mha.heads;
+    mha.window = 0;
+    mha.inputs = 3 * mha.c;
+    layer_cost c = cost_layer(hardware, l);
+    layer_cost m = cost_layer(hardware, &mha);
+    float data = c.mem, mha_data = m.mem;
+    //the q|k|v projection in front of it is narrower too
+    layer *prev = i > 0 ? &net->layers[i - 1] : 0;
+    if(prev && prev->type == CONNECTED && prev->outputs == l->inputs) {
+      layer proj = *prev;
+      proj.outputs = mha.inputs;
+      data += cost_layer(hardware, prev).mem;
+      mha_data += cost_layer(hardware, &proj).mem;
+    }
+    saved += layer_repeats(net, l) * (mha_data - data);
+    printf("%5d  %5d  %8d  %6d  %11.3f  %13.3f  %9.3f  %12.3f  %8.2f  %12.5f  %12.5f\n", i, l->heads, l->kv_heads,
+        l->window, kv_cache_bytes(hardware, l) / (1024 * 1024), kv_cache_bytes(hardware, &mha) / (1024 * 1024),
+        data / (1024 * 1024), mha_data / (1024 * 1024), mha_data > 0 ? 100 * (1 - data / mha_data) : 0,
+        layer_latency(&c), layer_latency(&m));
+  }
+  if(any) {
+    net_cost n = cost_network(hardware, net);
+    printf("\nNetwork Data Saved     : %.3f MB (%.2f%% of the mha network)\n", saved / (1024 * 1024),
+        n.mem + saved > 0 ? 100 * saved / (n.mem + saved) : 0);
+    printf("===========kv cache=======================\n\n\n");
+  }
+}
 
-void operations(char *asicfile, char *cfgfile) {
+//embedding gathers: how much the hot-row cache serves, and whether the misses are limited by
+//bandwidth or by the latency of requests in flight
+void print_embedding(asic *hardware, network *net) {
+  int i, any = 0;
+  for(i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    if(l->type != EMBEDDING) continue;
+    if(!any) {
+      printf("===========embedding======================\n");
+      printf("Outstanding Requests   : %d of %.5f us\n", hardware->outstanding, hardware->latency);
+      printf("Layer      Vocab    Dim  Lookups  Row(B)  Bursts  Hit(%%)      Gathers     Gather(us)   Latency(us)   Compute(us)  Bound      GB/s\n");
+      any = 1;
+    }
+    layer_cost c = cost_layer(hardware, l);
+    float row = (float)dtype_size(hardware->mac_dtype) * l->c;
+    float bw = mem_time(hardware, c.mem_in, dram_efficiency(hardware, GATHER, c.mem_in, row));
+    float wait = gather_latency_time(hardware, c.in_requests);
+    char *bound = c.alu_perf > c.mem_perf ? "compute" : wait > bw ? "latency" : "bandwidth";
+    int samples = (l->batch > 0 ? l->batch : 1) * (l->seq_len > 0 ? l->seq_len : 1);
+    printf("%5d  %9d  %5d  %7d  %6.0f  %6.0f  %6.2f  %11.0f  %13.5f  %12.5f  %12.5f  %-9s  %8.3f\n", i, l->vocab,
+        l->c, l->lookups * samples, row, ceil(row / hardware->dram_burst), 100 * embedding_hit_rate(hardware, l),
+        c.in_requests, bw, wait, c.alu_perf, bound, c.mem_perf > 0 ? c.mem / c.mem_perf * 1e6 / (1024 * 1024 * 1024) : 0);
+  }
+  if(any) printf("===========embedding======================\n\n\n");
+}
+
+void operations(char *asicfile, char *cfgfile, int event, char *tracefile, int dvfs, float slack, int tune, int sensitivity, int prefetch, int convs, serving_config *serve, train_config *train) {
   asic *hardware = (asic*)xmalloc(sizeof(asic));
   parse_hardware_cfg(asicfile, hardware);
-  int mac_dtype;
-  int vec_dtype;
-  int surpass_dtype;
+  profile_begin(PROFILE_OUTPUT);
   printf("\n===========processor info=================\n");
   printf("Tensor Alu Number            : %d\n", hardware->mac_num);
+  if(has_mac_array(hardware)) {
+    printf("Tensor Alu Array             : %d x %d\n", hardware->mac_rows, hardware->mac_cols);
+    printf("Tensor Alu Dataflow          : %s\n", get_dataflow_string(hardware->dataflow));
+  }
   if(hardware->mac_dtype == 1) {
     printf("Tensor Alu Dtype             : half\n");
-    mac_dtype = 2;
   } else if(hardware->mac_dtype == 2) {
     printf("Tensor Alu Dtype             : float\n");
-    mac_dtype = 4;
   }
   if(hardware->mac_pipeline == 1) {
     printf("Tensor Alu Is Full Pipeline  : yes\n");
@@ -34,10 +163,8 @@ void operations(char *asicfile, char *cfgfile) {
   printf("Vector Alu Number            : %d\n", hardware->vec_num);
   if(hardware->vec_dtype == 1) {
     printf("Vector Alu Dtype             : half\n");
-    vec_dtype = 2;
   } else if(hardware->vec_dtype == 2) {
     printf("Vector Alu Dtype             : float\n");
-    vec_dtype = 4;
   }
   if(hardware->vec_pipeline == 1) {
     printf("Vector Alu Is Full Pipeline  : yes\n");
@@ -49,10 +176,8 @@ void operations(char *asicfile, char *cfgfile) {
     printf("Surpass Alu Number           : %d\n", hardware->surpass_num);
     if(hardware->surpass_dtype == 1) {
       printf("Surpass Alu Dtype            : half\n");
-      surpass_dtype = 2;
     } else if(hardware->surpass_dtype == 2) {
       printf("Surpass Alu Dtype            : float\n");
-      surpass_dtype = 4;
     }
   } else {
     printf("Surpass Alu Supported        : no\n");
@@ -62,203 +187,73 @@ void operations(char *asicfile, char *cfgfile) {
   printf("Offchip Bandwidth            : %.5f GB/s\n", hardware->off_bw);
   printf("Offchip Latency              : %.5f us\n", hardware->latency);
   printf("Frequency                    : %.5f GHz\n", hardware->freq);
-  printf("Average Alu Efficiency       : %.5f%%\n", hardware->ave_alu_eff);
-  printf("Average Bandwidth Efficiency : %.5f%%\n", hardware->ave_bw_eff);
+  if(event || tracefile) {
+    printf("DMA Engines                  : %d\n", hardware->dma_num);
+    if(!has_dram_model(hardware)) printf("DRAM Channels                : %d\n", hardware->dram_channels);
+    printf("On-chip Buffer               : %d KB\n", hardware->sram_size);
+    printf("Tile Size                    : %d KB\n", hardware->tile_size);
+  }
+  if(has_mac_array(hardware)) {
+    printf("Average Alu Efficiency       : %.5f%% (vector alu only)\n", hardware->ave_alu_eff);
+  } else {
+    printf("Average Alu Efficiency       : %.5f%%\n", hardware->ave_alu_eff);
+  }
+  if(has_dram_model(hardware)) {
+    printf("DRAM Channels                : %d\n", hardware->dram_channels);
+    printf("DRAM Burst / Page            : %d B / %d B\n", hardware->dram_burst, hardware->dram_page);
+    printf("DRAM Banks Per Channel       : %d\n", hardware->dram_banks);
+    printf("DRAM Row Miss                : %.5f ns\n", hardware->dram_row_miss);
+  } else {
+    printf("Average Bandwidth Efficiency : %.5f%%\n", hardware->ave_bw_eff);
+  }
   if(hardware->surpass_num > 0) {
     printf("Surpass Efficiency           : %.5f%%\n", hardware->surpass_eff);
   }
   printf("===========processor info=================\n");
   printf("\n\n===========operator info==================\n");
+  profile_end(PROFILE_OUTPUT);
 
   network net = parse_network_cfg(cfgfile);
+  warn_inexact_convs(hardware, &net);
   int i;
   float ops = 0;
   float mem = 0;
-  float alu_perf;
-  float mem_perf;
+  float alu_perf = 0;
+  float mem_perf = 0;
   int alu_bottleneck; 
   float peak_perf;
   float worst_perf;
-
-  //advanced usage
-  //问题在于这样的评估方式是否合理，直接用1/(阻塞排数+1)来表示流水效率
-  float vec_alu_pipe_eff = hardware->vec_pipeline == 1 ? 1 : 1/(hardware->vec_stall_cycle + 1);
-  float mac_alu_pipe_eff = hardware->mac_pipeline == 1 ? 1 : 1.0/(hardware->mac_stall_cycle + 1);
-
+  float energy = 0;
+  int energy_model = has_energy_model(hardware);
+
+  timeline *trace = tracefile ? make_timeline() : 0;
+  engine *e = (event || trace) ? make_engine(hardware, trace) : 0;
+  if(net.blocks > 1) {
+    printf("Blocks                 : %d (layer rows and the event simulation are one block, totals the whole model)\n",
+        net.blocks);
+  }
+  printf("Layer  Type             Unit      Alu Eff(%%)  BW Eff(%%)   Compute(us)    Memory(us)");
+  printf(energy_model ? "    Energy(uJ)\n" : "\n");
   for(i = 0; i < net.n; ++i) {
-    layer l = net.layers[i];
-    if(l.type == CONVOLUTIONAL) {
-      //ops
-      ops += 2 * l.n * l.size * l.size * l.c * l.out_h * l.out_w;
-      // filter_num * filter_size^2 * channels * out_h * out_w
-
-      //mem
-      mem += mac_dtype * l.w * l.h * l.c;
-      mem += mac_dtype * l.size * l.size * l.c * l.n;
-      mem += vec_dtype * l.n * l.out_h * l.out_w;
-
-      //perf
-      //完成一次conv的时间
-      alu_perf = (((((ops / hardware->mac_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * mac_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == BATCHNORM) {
-      //ops
-      ops += l.w * l.h * l.c; //for mean
-      ops += l.w * l.h * l.c * 4; //for var
-      ops += l.w * l.h * l.c; //for scale
-      ops += l.w * l.h * l.c * 2; //for bias
-
-      //mem
-      mem += l.w * l.h * l.c * 2 * vec_dtype;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == ACTIVE) {
-      if(hardware->surpass_num > 0) {  //using surpass alu
-        //ops
-        ops += l.inputs;
-
-        //mems
-        mem += 2 * surpass_dtype * l.inputs;
-
-        //perf
-        alu_perf = (((((ops / hardware->surpass_num)) / hardware->freq) / (1000))) / (hardware->surpass_eff/100);
-        mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-      } else { //using taylor expansion, 1/(1+e^(-x)) = 1/2 + (1/4)*x - (1/48)*x^3
-        //ops
-        ops += 3 * l.inputs + 2 * l.inputs + 4 * l.inputs;;
-
-        //mems
-        mem += 2 * vec_dtype * l.inputs;
-
-        //perf
-        alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-        mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-      }
-    } else if(l.type == RELU) {
-      //ops
-      ops += l.inputs;
-
-      //mems
-      mem += 2 * vec_dtype * l.inputs;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / (hardware->ave_alu_eff/100);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == AVGPOOL) {
-      //ops
-      ops += 2 * l.size * l.size * l.c * l.out_h * l.out_w;
-
-      //mem
-      mem += vec_dtype * l.c * l.w * l.h;
-      mem += vec_dtype * l.out_c * l.out_w * l.out_h;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == MAXPOOL){
-      //ops
-      ops += 2 * l.size * l.size * l.c * l.out_h * l.out_w;
-
-      //mem
-      mem += vec_dtype * l.c * l.w * l.h;
-      mem += vec_dtype * l.out_c * l.out_w * l.out_h;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == CONNECTED) {
-      //ops
-      ops += 2 * l.inputs * l.outputs;
-
-      //mem
-      mem += mac_dtype * l.inputs;
-      mem += mac_dtype * l.inputs * l.outputs;
-      mem += vec_dtype * l.outputs;
-
-      //perf
-      alu_perf = (((((ops / hardware->mac_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * mac_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if (l.type == RNN) {
-      //ops
-      ops += 2 * l.input_layer->inputs * l.input_layer->outputs;
-      ops += 2 * l.self_layer->inputs * l.self_layer->outputs;
-      ops += 2 * l.output_layer->inputs * l.output_layer->outputs;
-      ops *= l.n;
-
-      //mem
-      mem += mac_dtype * l.input_layer->inputs;
-      mem += mac_dtype * l.input_layer->inputs * l.input_layer->outputs;
-      mem += mac_dtype * l.self_layer->inputs * l.self_layer->outputs;
-      mem += mac_dtype * l.output_layer->inputs * l.output_layer->outputs;
-      mem += vec_dtype * l.input_layer->outputs;
-
-      //perf
-      alu_perf = (((((ops / hardware->mac_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * mac_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if (l.type == LSTM) {
-      //ops
-      ops += 2 * l.uf->inputs * l.uf->outputs;
-      ops += 2 * l.ui->inputs * l.ui->outputs;
-      ops += 2 * l.ug->inputs * l.ug->outputs;
-      ops += 2 * l.uo->inputs * l.uo->outputs;
-      ops += 2 * l.wf->inputs * l.wf->outputs;
-      ops += 2 * l.wi->inputs * l.wi->outputs;
-      ops += 2 * l.wg->inputs * l.wg->outputs;
-      ops += 2 * l.wo->inputs * l.wo->outputs;
-
-      //mem
-      mem += mac_dtype * l.uf->inputs;
-      mem += mac_dtype * l.uf->inputs * l.uf->outputs;
-      mem += mac_dtype * l.ui->inputs * l.ui->outputs;
-      mem += mac_dtype * l.ug->inputs * l.ug->outputs;
-      mem += mac_dtype * l.uo->inputs * l.uo->outputs;
-      mem += mac_dtype * l.wf->inputs * l.wf->outputs;
-      mem += mac_dtype * l.wi->inputs * l.wi->outputs;
-      mem += mac_dtype * l.wg->inputs * l.wg->outputs;
-      mem += vec_dtype * l.wo->outputs;
-
-      //perf
-      alu_perf = (((((ops / hardware->mac_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * mac_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == LRN) {
-      float x = 100/hardware->surpass_eff;
-      if (hardware->surpass_num == 0) {  //taylor expansion, 1/x
-        x = 10; //approximation
-      }
-      //ops
-      ops += l.c * l.h * l.w * (2 * l.n * l.n * x + 2);
-
-      //mem
-      mem += 2 * vec_dtype * l.c * l.w * l.h;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == DECONV) {
-      //ops
-      ops += 2 * l.n * l.size * l.size * l.c * l.h * l.w;
-
-      //mem
-      mem += vec_dtype * l.w * l.h * l.c;
-      mem += vec_dtype * l.size * l.size * l.c * l.n;
-      mem += vec_dtype * l.n * l.out_h * l.out_w;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
-    } else if(l.type == UNPOOL) {
-      //ops
-      ops += l.size * l.size * l.c * l.out_h * l.out_w;
-
-      //mem
-      mem += vec_dtype * l.w * l.h * l.c;
-      mem += vec_dtype * l.out_c * l.out_h * l.out_w;
-
-      //perf
-      alu_perf = (((((ops / hardware->vec_num)) / hardware->freq) / (1000))) / ((hardware->ave_alu_eff/100) * vec_alu_pipe_eff);
-      mem_perf = (((mem / (1024 * 1024 * 1024)) / hardware->off_bw) * 1000 * 1000 ) / (hardware->ave_bw_eff/100);// + hardware->latency;
+    profile_begin(PROFILE_COST);
+    layer_cost c = cost_layer(hardware, &net.layers[i]);
+    profile_end(PROFILE_COST);
+    profile_begin(PROFILE_OUTPUT);
+    printf("%5d  %-15s  %-8s  %10.3f  %9.3f  %12.5f  %12.5f", i, get_layer_string(net.layers[i].type),
+        get_unit_string(c.unit), c.util, c.bw_eff, c.alu_perf, c.mem_perf);
+    if(energy_model) printf("  %12.5f\n", c.energy);
+    else printf("\n");
+    profile_end(PROFILE_OUTPUT);
+    float r = layer_repeats(&net, &net.layers[i]);
+    energy += r * c.energy;
+    ops += r * c.ops;
+    mem += r * c.mem;
+    alu_perf += r * c.alu_perf;
+    mem_perf += r * c.mem_perf;
+    if(e) {
+      profile_begin(PROFILE_ENGINE);
+      simulate_layer(e, c, i);
+      profile_end(PROFILE_ENGINE);
     }
   }
 
@@ -266,14 +261,21 @@ void operations(char *asicfile, char *cfgfile) {
   peak_perf = (alu_bottleneck  == 1) ? alu_perf : mem_perf;
   worst_perf  = alu_perf + mem_perf;
 
+  profile_begin(PROFILE_OUTPUT);
   printf("Total Compute Operations : %f GOPs\n", ops/(1000*1000*1000));
   printf("Total Data Sizes         : %f MB\n", mem/(1024*1024));
   printf("===========operator info==================\n\n\n");
   printf("===========performance====================\n");
   printf("Peak Performance       : %.5f us\n", peak_perf);
   printf("Worst Performance      : %.5f us\n", worst_perf);
-  printf("Peak Power Efficiency  : %.5f\n", 1/(hardware->pwr*peak_perf));
-  printf("Worst Power Efficiency : %.5f\n", 1/(hardware->pwr*worst_perf));
+  if(energy_model) {
+    //inferences per uJ, from the modeled energy instead of a constant power
+    printf("Peak Power Efficiency  : %.5f\n", 1/(energy + static_energy(hardware, peak_perf)));
+    printf("Worst Power Efficiency : %.5f\n", 1/(energy + static_energy(hardware, worst_perf)));
+  } else {
+    printf("Peak Power Efficiency  : %.5f\n", 1/(hardware->pwr*peak_perf));
+    printf("Worst Power Efficiency : %.5f\n", 1/(hardware->pwr*worst_perf));
+  }
   printf("Peak Area Efficiency   : %.5f\n", 1/(hardware->area*peak_perf));
   printf("Worst Area Efficiency  : %.5f\n", 1/(hardware->area*worst_perf));
   if(alu_bottleneck == 1) {
@@ -283,9 +285,124 @@ void operations(char *asicfile, char *cfgfile) {
   }
   printf("===========performance====================\n\n\n");
 
+  if(energy_model) {
+    float leak = static_energy(hardware, peak_perf);
+    printf("===========energy=========================\n");
+    printf("Dynamic Energy         : %.5f uJ\n", energy);
+    printf("Static Energy          : %.5f uJ\n", leak);
+    printf("Energy Per Inference   : %.5f uJ\n", energy + leak);
+    printf("Average Power          : %.5f W\n", (energy + leak) / peak_perf);
+    printf("===========energy=========================\n\n\n");
+  }
+  print_recurrent(hardware, &net);
+  print_kv_cache(hardware, &net);
+  print_embedding(hardware, &net);
+  moe_report(hardware, &net);
+  if(hardware->tier_num > 0) tiers_report(hardware, &net);
+  profile_end(PROFILE_OUTPUT);
+
+  profile_begin(PROFILE_ANALYSIS);
+  if(dvfs) dvfs_report(hardware, &net, slack);
+  if(tune) autotune_report(hardware, &net);
+  if(sensitivity) sensitivity_report(hardware, &net);
+  if(prefetch) prefetch_report(hardware, &net);
+  if(convs) conv_report(hardware, &net);
+  if(serve) serving_report(hardware, &net, serve);
+  if(train) training_report(hardware, &net, train);
+  profile_end(PROFILE_ANALYSIS);
+
+  profile_begin(PROFILE_OUTPUT);
+  if(e) {
+    print_engine(e);
+    free_engine(e);
+  }
+  if(trace) {
+    write_trace(tracefile, trace, &net, hardware);
+    printf("Trace written to %s (%d slices)\n\n", tracefile, trace->n);
+    free_timeline(trace);
+  }
+  profile_end(PROFILE_OUTPUT);
+  free_network(net);
   free(hardware);
 }
 
+void colocation(char *asicfile, char **cfgfiles, int n, char *slos, int step) {
+  asic *hardware = (asic*)xmalloc(sizeof(asic));
+  parse_hardware_cfg(asicfile, hardware);
+  network nets[MAX_MODELS];
+  float slo[MAX_MODELS] = {0};
+  int i;
+  //one slo per network cfg, in the same order; the report warns about models past MAX_MODELS
+  parse_float_list(slos, slo, MAX_MODELS);
+  for (i = 0; i < n && i < MAX_MODELS; ++i) nets[i] = parse_network_cfg(cfgfiles[i]);
+  printf("\n");
+  profile_begin(PROFILE_ANALYSIS);
+  colocate_report(hardware, nets, cfgfiles, n, slo, step);
+  profile_end(PROFILE_ANALYSIS);
+  for (i = 0; i < n && i < MAX_MODELS; ++i) free_network(nets[i]);
+  free(hardware);
+}
+
+void sweep(char *asicfile, char *cfgfile, char *space, char *out, int threads, int top) {
+  asic *hardware = (asic*)xmalloc(sizeof(asic));
+  parse_hardware_cfg(asicfile, hardware);
+  network net = parse_network_cfg(cfgfile);
+  sweep_spec spec;
+  parse_sweep(space, &spec);
+  printf("\n");
+  profile_begin(PROFILE_ANALYSIS);
+  sweep_report(hardware, &net, &spec, out, threads, top);
+  profile_end(PROFILE_ANALYSIS);
+  free_sweep(&spec);
+  free_network(net);
+  free(hardware);
+}
+
+void dimension(char *asicfile, char *cfgfile, char *name, float *values, int n) {
+  asic *hardware = (asic*)xmalloc(sizeof(asic));
+  parse_hardware_cfg(asicfile, hardware);
+  //the file is read once, each value only rebuilds the layers
+  list *sections = read_cfg(cfgfile);
+  printf("\n");
+  profile_begin(PROFILE_ANALYSIS);
+  dims_report(hardware, sections, name, values, n);
+  profile_end(PROFILE_ANALYSIS);
+  free_sections(sections);
+  free(hardware);
+}
+
+void attention(char *asicfile, char *cfgfile, float *lengths, int n) {
+  asic *hardware = (asic*)xmalloc(sizeof(asic));
+  parse_hardware_cfg(asicfile, hardware);
+  profile_begin(PROFILE_PARSE);
+  network net = parse_network_cfg(cfgfile);
+  profile_end(PROFILE_PARSE);
+  printf("\n");
+  profile_begin(PROFILE_ANALYSIS);
+  attention_report(hardware, &net, lengths, n);
+  profile_end(PROFILE_ANALYSIS);
+  free_network(net);
+  free(hardware);
+}
+
+void speculation(char *asicfile, char *cfgfile, char *draftfile, speculative_config *cfg) {
+  asic *hardware = (asic*)xmalloc(sizeof(asic));
+  parse_hardware_cfg(asicfile, hardware);
+  network target = parse_network_cfg(cfgfile);
+  network draft = parse_network_cfg(draftfile);
+  //blocks= in the [net] sections unless given on the command line
+  if (cfg->blocks > 0) target.blocks = cfg->blocks;
+  else cfg->blocks = target.blocks;
+  if (cfg->draft_blocks > 0) draft.blocks = cfg->draft_blocks;
+  else cfg->draft_blocks = draft.blocks;
+  printf("\n");
+  profile_begin(PROFILE_ANALYSIS);
+  speculative_report(hardware, &target, &draft, cfg);
+  profile_end(PROFILE_ANALYSIS);
+  free_network(target);
+  free_network(draft);
+  free(hardware);
+}
 
 int main(int argc, char **argv) {
   int i;
@@ -294,7 +411,124 @@ int main(int argc, char **argv) {
     strip_args(argv[i]);
   }
 
-  operations(argv[1],argv[2]);
+  if(find_arg(argc, argv, "--stats")) enable_profile();
+  int event = find_arg(argc, argv, "--engine");
+  char *tracefile = find_char_arg(argc, argv, "--trace", 0);
+  int dvfs = find_arg(argc, argv, "--dvfs");
+  float slack = find_float_arg(argc, argv, "--slack", 5);
+  int tune = find_arg(argc, argv, "--tune");
+  int sensitivity = find_arg(argc, argv, "--sensitivity");
+  int prefetch = find_arg(argc, argv, "--prefetch");
+  int convs = find_arg(argc, argv, "--conv");
+  int train = find_arg(argc, argv, "--train");
+  train_config tcfg;
+  tcfg.optimizer = get_optimizer(find_char_arg(argc, argv, "--optimizer", "adam"));
+  tcfg.recompute = get_recompute(find_char_arg(argc, argv, "--recompute", "none"));
+  int serve = find_arg(argc, argv, "--serve");
+  serving_config scfg = {0};
+  scfg.policy = get_batch_policy(find_char_arg(argc, argv, "--policy", "dynamic"));
+  scfg.rate = find_float_arg(argc, argv, "--rate", 1000);
+  scfg.requests = find_int_arg(argc, argv, "--requests", 10000);
+  scfg.max_batch = find_int_arg(argc, argv, "--max_batch", 8);
+  scfg.timeout = find_float_arg(argc, argv, "--timeout", 1000);
+  scfg.length = find_int_arg(argc, argv, "--length", 1);
+  scfg.arrivals = find_char_arg(argc, argv, "--arrivals", 0);
+  scfg.seed = find_int_arg(argc, argv, "--seed", 1);
+  int colocate = find_arg(argc, argv, "--colocate");
+  char *slos = find_char_arg(argc, argv, "--slo", 0);
+  int step = find_int_arg(argc, argv, "--step", 10);
+  char *calibration = find_char_arg(argc, argv, "--calibrate", 0);
+  char *space = find_char_arg(argc, argv, "--sweep", 0);
+  char *out = find_char_arg(argc, argv, "--out", 0);
+  int threads = find_int_arg(argc, argv, "--threads", 0);
+  int top = find_int_arg(argc, argv, "--top", 10);
+  char *lengths = find_char_arg(argc, argv, "--attention", 0);
+  char *draft = find_char_arg(argc, argv, "--draft", 0);
+  speculative_config spec_cfg = {0};
+  float drafts[MAX_DRAFT_TOKENS];
+  spec_cfg.n = parse_range_list(find_char_arg(argc, argv, "--k", "1:8:8"), drafts, MAX_DRAFT_TOKENS);
+  for (i = 0; i < spec_cfg.n; ++i) spec_cfg.k[i] = (int)(drafts[i] + 0.5f);
+  spec_cfg.accept = find_float_arg(argc, argv, "--accept", 0.7);
+  spec_cfg.blocks = find_int_arg(argc, argv, "--blocks", 0);
+  spec_cfg.draft_blocks = find_int_arg(argc, argv, "--draft_blocks", 0);
+  //--dim S=512 binds a symbolic dimension, one --dim with several values draws its curve
+  char *dim;
+  char curve[32] = {0};
+  float curve_values[MAX_DIM_VALUES];
+  int ncurve = 0;
+  while((dim = find_char_arg(argc, argv, "--dim", 0))) {
+    char name[32];
+    float values[MAX_DIM_VALUES];
+    int n = parse_dim(dim, name, values, MAX_DIM_VALUES);
+    if(n == 1) {
+      bind_symbol(name, (int)(values[0] + 0.5f));
+    } else if(n > 1) {
+      if(ncurve) error("only one --dim can take several values");
+      strcpy(curve, name);
+      memcpy(curve_values, values, n * sizeof(float));
+      ncurve = n;
+    }
+  }
+  if(calibration && argc > 1 && argv[1]) {
+    asic *hardware = (asic*)xmalloc(sizeof(asic));
+    parse_hardware_cfg(argv[1], hardware);
+    profile_begin(PROFILE_ANALYSIS);
+    calibrate_report(hardware, calibration);
+    profile_end(PROFILE_ANALYSIS);
+    free(hardware);
+    if(prof.enabled) print_profile();
+    return 0;
+  }
+  if(argc < 3 || !argv[1] || !argv[2]) {
+    fprintf(stderr, "usage: %s <hardware cfg> <network cfg> [--engine] [--trace out.json] [--dvfs [--slack 5]] [--tune] [--sensitivity] [--prefetch] [--conv] [--stats]\n", argv[0]);
+    fprintf(stderr, "       [--train [--optimizer sgd|momentum|adam] [--recompute none|attention|checkpoint]]\n");
+    fprintf(stderr, "       [--serve [--policy static|dynamic|continuous] [--rate 1000] [--requests 10000]\n");
+    fprintf(stderr, "        [--max_batch 8] [--timeout 1000] [--length 1] [--arrivals trace.csv] [--seed 1]]\n");
+    fprintf(stderr, "       %s <hardware cfg> <network cfg>... --colocate [--slo 100,200] [--step 10]\n", argv[0]);
+    fprintf(stderr, "       %s <hardware cfg> --calibrate measured.csv\n", argv[0]);
+    fprintf(stderr, "       %s <hardware cfg> <network cfg> --dim S=128,256,512 [--dim B=1]\n", argv[0]);
+    fprintf(stderr, "       %s <hardware cfg> <network cfg> --attention 512,1024,4096\n", argv[0]);
+    fprintf(stderr, "       %s <hardware cfg> <target cfg> --draft <draft cfg> [--k 1:8:8] [--accept 0.7] [--blocks n] [--draft_blocks n]\n", argv[0]);
+    fprintf(stderr, "       %s <hardware cfg> <network cfg> --sweep \"key=v1,v2;key=lo:hi:n\" [--out sweep.bin] [--threads 0] [--top 10]\n", argv[0]);
+    return 0;
+  }
+
+  if(colocate) {
+    int n = 0;
+    while (2 + n < argc && argv[2 + n]) ++n;
+    colocation(argv[1], argv + 2, n, slos, step);
+    if(prof.enabled) print_profile();
+    return 0;
+  }
+
+  if(ncurve) {
+    dimension(argv[1], argv[2], curve, curve_values, ncurve);
+    if(prof.enabled) print_profile();
+    return 0;
+  }
+
+  if(draft) {
+    speculation(argv[1], argv[2], draft, &spec_cfg);
+    if(prof.enabled) print_profile();
+    return 0;
+  }
+
+  if(lengths) {
+    float values[MAX_ATTENTION_LENGTHS];
+    int n = parse_range_list(lengths, values, MAX_ATTENTION_LENGTHS);
+    attention(argv[1], argv[2], values, n);
+    if(prof.enabled) print_profile();
+    return 0;
+  }
+
+  if(space) {
+    sweep(argv[1], argv[2], space, out, threads, top);
+    if(prof.enabled) print_profile();
+    return 0;
+  }
+
+  operations(argv[1], argv[2], event, tracefile, dvfs, slack, tune, sensitivity, prefetch, convs, serve ? &scfg : 0, train ? &tcfg : 0);
+  if(prof.enabled) print_profile();
 
   return 0;
 }
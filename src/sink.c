@@ -0,0 +1,293 @@
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sink.h"
+#include "utils.h"
+
+char *get_metric_string(SINK_METRIC m) {
+  switch(m) {
+    case COL_PEAK:
+      return "peak_us";
+    case COL_WORST:
+      return "worst_us";
+    case COL_ALU:
+      return "alu_us";
+    case COL_MEM:
+      return "mem_us";
+    case COL_ENERGY:
+      return "energy_uj";
+    case COL_EFFICIENCY:
+      return "efficiency";
+    default:
+      break;
+  }
+  return "none";
+}
+
+static void init_stats(sink_stats *st, int top) {
+  memset(st, 0, sizeof(sink_stats));
+  st->fastest.k = st->efficient.k = top;
+  st->min = INFINITY;
+  st->max = 0;
+}
+
+sink *open_sink(char *filename, long rows, int nparams, char **names, float **values, int *nvalues, int top) {
+  sink *s = (sink*)xcalloc(1, sizeof(sink));
+  int i;
+  s->fd = -1;
+  s->filename = filename;
+  s->rows = rows;
+  s->nparams = nparams;
+  s->ncols = nparams + NUM_METRICS;
+  for (i = 0; i < nparams; ++i) {
+    s->names[i] = names[i];
+    s->values[i] = values[i];
+    s->nvalues[i] = nvalues[i];
+  }
+  if (top < 1) top = 1;
+  if (top > MAX_TOP_K) top = MAX_TOP_K;
+  init_stats(&s->stats, top);
+  //columns start on page boundaries so each one can be mapped on its own
+  s->column_stride = ((int64_t)rows * sizeof(float) + 4095) / 4096 * 4096;
+  if (!filename) return s;
+
+  s->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (s->fd < 0) file_error(filename);
+  if (ftruncate(s->fd, SINK_HEADER + s->ncols * s->column_stride) != 0) file_error(filename);
+  char *header = (char*)xcalloc(SINK_HEADER, 1);
+  sink_header *h = (sink_header*)header;
+  memcpy(h->magic, "SIMSWEEP", 8);
+  h->version = 1;
+  h->ncols = s->ncols;
+  h->rows = rows;
+  h->data_offset = SINK_HEADER;
+  h->column_stride = s->column_stride;
+  char *name = header + 64;
+  for (i = 0; i < s->ncols; ++i, name += 32) {
+    strncpy(name, i < nparams ? names[i] : get_metric_string((SINK_METRIC)(i - nparams)), 31);
+  }
+  if (pwrite(s->fd, header, SINK_HEADER, 0) != SINK_HEADER) file_error(filename);
+  free(header);
+  return s;
+}
+
+sink_buffer *make_sink_buffer(sink *s) {
+  sink_buffer *b = (sink_buffer*)xcalloc(1, sizeof(sink_buffer));
+  if (s->fd >= 0) b->cols = (float*)xcalloc((size_t)s->ncols * SINK_CHUNK, sizeof(float));
+  init_stats(&b->stats, s->stats.fastest.k);
+  return b;
+}
+
+static void swap_entries(top_k *t, int i, int j) {
+  float key = t->key[i];
+  sink_record r = t->r[i];
+  t->key[i] = t->key[j];
+  t->r[i] = t->r[j];
+  t->key[j] = key;
+  t->r[j] = r;
+}
+
+//ties go to the lower point so the result doesn't depend on how threads split the work
+static int worse(top_k *t, int i, int j) {
+  if (t->key[i] != t->key[j]) return t->key[i] < t->key[j];
+  return t->r[i].index > t->r[j].index;
+}
+
+static void top_k_push(top_k *t, float key, sink_record *r) {
+  int i;
+  if (t->n < t->k) {
+    i = t->n++;
+    t->key[i] = key;
+    t->r[i] = *r;
+    while (i > 0 && worse(t, i, (i - 1) / 2)) {
+      swap_entries(t, i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+    return;
+  }
+  if (key < t->key[0] || (key == t->key[0] && r->index > t->r[0].index)) return;
+  t->key[0] = key;
+  t->r[0] = *r;
+  i = 0;
+  for (;;) {
+    int l = 2 * i + 1, m = i;
+    if (l < t->n && worse(t, l, m)) m = l;
+    if (l + 1 < t->n && worse(t, l + 1, m)) m = l + 1;
+    if (m == i) break;
+    swap_entries(t, i, m);
+    i = m;
+  }
+}
+
+static int hist_bin(double t) {
+  if (t <= 0) return 0;
+  int bin = (int)floor(log2(t) * HIST_OCTAVE) - HIST_MIN_EXP * HIST_OCTAVE;
+  if (bin < 0) return 0;
+  return bin < HIST_BINS ? bin : HIST_BINS - 1;
+}
+
+static void update_stats(sink_stats *st, int nparams, sink_record *r) {
+  float peak = r->metric[COL_PEAK];
+  double lt = log(peak > 1e-12 ? peak : 1e-12);
+  int p;
+  ++st->n;
+  if (peak < st->min) st->min = peak;
+  if (peak > st->max) st->max = peak;
+  ++st->hist[hist_bin(peak)];
+  for (p = 0; p < nparams; ++p) {
+    st->log_sum[p][r->value[p]] += lt;
+    ++st->count[p][r->value[p]];
+  }
+  top_k_push(&st->fastest, -peak, r);
+  top_k_push(&st->efficient, r->metric[COL_EFFICIENCY], r);
+}
+
+void sink_flush(sink *s, sink_buffer *b) {
+  int c;
+  if (s->fd >= 0 && b->n > 0) {
+    size_t bytes = b->n * sizeof(float);
+    for (c = 0; c < s->ncols; ++c) {
+      off_t offset = SINK_HEADER + c * s->column_stride + b->start * sizeof(float);
+      if (pwrite(s->fd, b->cols + (size_t)c * SINK_CHUNK, bytes, offset) != (ssize_t)bytes) file_error(s->filename);
+    }
+  }
+  b->n = 0;
+}
+
+void sink_write(sink *s, sink_buffer *b, sink_record *r) {
+  if (b->n == SINK_CHUNK || (b->n > 0 && r->index != b->start + b->n)) sink_flush(s, b);
+  if (b->n == 0) b->start = r->index;
+  if (s->fd >= 0) {
+    int p, m;
+    for (p = 0; p < s->nparams; ++p) b->cols[p * SINK_CHUNK + b->n] = s->values[p][r->value[p]];
+    for (m = 0; m < NUM_METRICS; ++m) b->cols[(s->nparams + m) * SINK_CHUNK + b->n] = r->metric[m];
+  }
+  ++b->n;
+  update_stats(&b->stats, s->nparams, r);
+}
+
+void sink_merge(sink *s, sink_buffer *b) {
+  sink_stats *st = &s->stats;
+  int i, p, v;
+  sink_flush(s, b);
+  st->n += b->stats.n;
+  if (b->stats.min < st->min) st->min = b->stats.min;
+  if (b->stats.max > st->max) st->max = b->stats.max;
+  for (i = 0; i < HIST_BINS; ++i) st->hist[i] += b->stats.hist[i];
+  for (p = 0; p < s->nparams; ++p) {
+    for (v = 0; v < s->nvalues[p]; ++v) {
+      st->log_sum[p][v] += b->stats.log_sum[p][v];
+      st->count[p][v] += b->stats.count[p][v];
+    }
+  }
+  for (i = 0; i < b->stats.fastest.n; ++i) top_k_push(&st->fastest, b->stats.fastest.key[i], &b->stats.fastest.r[i]);
+  for (i = 0; i < b->stats.efficient.n; ++i) top_k_push(&st->efficient, b->stats.efficient.key[i], &b->stats.efficient.r[i]);
+  free(b->cols);
+  free(b);
+}
+
+static double bin_upper(int bin) {
+  return pow(2, (double)(bin + 1) / HIST_OCTAVE + HIST_MIN_EXP);
+}
+
+static double percentile(sink_stats *st, double q) {
+  long target = (long)ceil(q * st->n);
+  long seen = 0;
+  int i;
+  if (target < 1) target = 1;
+  for (i = 0; i < HIST_BINS; ++i) {
+    seen += st->hist[i];
+    if (seen >= target) break;
+  }
+  double t = bin_upper(i < HIST_BINS ? i : HIST_BINS - 1);
+  if (t > st->max) t = st->max;
+  if (t < st->min) t = st->min;
+  return t;
+}
+
+static int name_width(char *name) {
+  int n = strlen(name);
+  return n > 10 ? n : 10;
+}
+
+static void print_top(sink *s, top_k *t, char *title) {
+  int order[MAX_TOP_K];
+  int i, j, p;
+  for (i = 0; i < t->n; ++i) order[i] = i;
+  //best first, k is small
+  for (i = 1; i < t->n; ++i) {
+    int o = order[i];
+    for (j = i; j > 0 && worse(t, order[j - 1], o); --j) order[j] = order[j - 1];
+    order[j] = o;
+  }
+  printf("%s\n", title);
+  printf("%4s  %10s", "rank", "point");
+  for (p = 0; p < s->nparams; ++p) printf("  %*s", name_width(s->names[p]), s->names[p]);
+  printf("  %12s  %12s  %10s\n", "peak(us)", "energy(uJ)", "efficiency");
+  for (i = 0; i < t->n; ++i) {
+    sink_record *r = &t->r[order[i]];
+    printf("%4d  %10ld", i + 1, r->index);
+    for (p = 0; p < s->nparams; ++p) printf("  %*g", name_width(s->names[p]), s->values[p][r->value[p]]);
+    printf("  %12.5f  %12.5f  %10.4f\n", r->metric[COL_PEAK], r->metric[COL_ENERGY], r->metric[COL_EFFICIENCY]);
+  }
+  printf("\n");
+}
+
+void sink_report(sink *s) {
+  sink_stats *st = &s->stats;
+  int i, p, v;
+  if (st->n == 0) return;
+  printf("===========sweep results==================\n");
+  printf("Points                 : %ld\n", st->n);
+  printf("Peak Latency Range     : %.5f .. %.5f us\n", st->min, st->max);
+  printf("Peak Latency P1/P50/P99: %.5f / %.5f / %.5f us (histogram, %d bins per octave)\n",
+      percentile(st, 0.01), percentile(st, 0.5), percentile(st, 0.99), HIST_OCTAVE);
+
+  //one line per octave between the fastest and slowest point
+  int lo = hist_bin(st->min) / HIST_OCTAVE, hi = hist_bin(st->max) / HIST_OCTAVE;
+  long most = 1;
+  for (i = lo; i <= hi; ++i) {
+    long n = 0;
+    for (v = 0; v < HIST_OCTAVE; ++v) n += st->hist[i * HIST_OCTAVE + v];
+    if (n > most) most = n;
+  }
+  printf("\n%26s  %10s\n", "peak latency(us)", "points");
+  for (i = lo; i <= hi; ++i) {
+    long n = 0;
+    for (v = 0; v < HIST_OCTAVE; ++v) n += st->hist[i * HIST_OCTAVE + v];
+    printf("[%11.5g, %11.5g)  %10ld  ", bin_upper(i * HIST_OCTAVE - 1), bin_upper((i + 1) * HIST_OCTAVE - 1), n);
+    for (v = 0; v < (int)(40 * n / most); ++v) printf("#");
+    printf("\n");
+  }
+  printf("\n");
+
+  print_top(s, &st->fastest, "Fastest points:");
+  print_top(s, &st->efficient, "Most efficient points (fraction of the tensor roofline):");
+
+  //main effect of each parameter: geometric mean latency over the points sharing a value
+  printf("%-28s  %14s  %14s  %12s\n", "Sensitivity", "best value", "worst value", "worst/best");
+  for (p = 0; p < s->nparams; ++p) {
+    int best = -1, worst = -1;
+    double bmean = 0, wmean = 0;
+    for (v = 0; v < s->nvalues[p]; ++v) {
+      if (st->count[p][v] == 0) continue;
+      double mean = st->log_sum[p][v] / st->count[p][v];
+      if (best < 0 || mean < bmean) best = v, bmean = mean;
+      if (worst < 0 || mean > wmean) worst = v, wmean = mean;
+    }
+    if (best < 0) continue;
+    printf("%-28s  %14g  %14g  %12.4f\n", s->names[p], s->values[p][best], s->values[p][worst], exp(wmean - bmean));
+  }
+  if (s->fd >= 0) {
+    printf("\nColumns written to %s (%d columns x %ld rows)\n", s->filename, s->ncols, s->rows);
+  }
+  printf("===========sweep results==================\n\n\n");
+}
+
+void close_sink(sink *s) {
+  if (s->fd >= 0) close(s->fd);
+  free(s);
+}
@@ -0,0 +1,72 @@
+#include <math.h>
+
+#include "speculative.h"
+#include "cost.h"
+#include "network.h"
+#include "utils.h"
+
+//expected tokens a round produces: the accepted prefix of k drafts plus the target's own token
+static float expected_tokens(float accept, int k) {
+  if (accept >= 1) return k + 1;
+  return (1 - pow(accept, k + 1)) / (1 - accept);
+}
+
+//acceptance rate at which a round of k drafts only matches plain decoding
+static float break_even(float plain, float round, int k) {
+  float lo = 0, hi = 1;
+  int i;
+  if (expected_tokens(1, k) * plain < round) return -1;
+  for (i = 0; i < 40; ++i) {
+    float mid = (lo + hi) / 2;
+    if (expected_tokens(mid, k) * plain < round) lo = mid;
+    else hi = mid;
+  }
+  return hi;
+}
+
+void speculative_report(asic *hardware, network *target, network *draft, speculative_config *cfg) {
+  int i;
+  int batch = target->batch > 0 ? target->batch : 1;
+  //both cfgs are costed as decoding steps, one token per sample, and the draft runs
+  //the target's batch
+  set_tokens_network(target, 1);
+  set_batch_network(draft, batch);
+  set_tokens_network(draft, 1);
+  net_cost t1 = cost_network(hardware, target);
+  net_cost d1 = cost_network(hardware, draft);
+  float plain = t1.peak_perf;
+  float step = d1.peak_perf;
+
+  printf("===========speculative decoding===========\n");
+  printf("Acceptance Rate        : %.3f\n", cfg->accept);
+  printf("Target Token           : %.5f us (%d blocks, %s bound)\n", plain, cfg->blocks,
+      t1.alu_perf > t1.mem_perf ? "compute" : "memory");
+  printf("Draft Token            : %.5f us (%d blocks, %.2f%% of the target)\n", step, cfg->draft_blocks,
+      plain > 0 ? 100 * step / plain : 0);
+  printf("Plain Decode           : %.2f tokens/s\n\n", plain > 0 ? batch * 1e6 / plain : 0);
+  printf("%4s  %12s  %12s  %8s  %8s  %10s  %12s  %12s  %8s  %10s\n", "k", "Draft(us)", "Verify(us)", "Verify/1",
+      "Bound", "Tokens", "Round(us)", "Tokens/s", "Speedup", "Break-even");
+  int best = -1;
+  float best_speedup = 0;
+  for (i = 0; i < cfg->n; ++i) {
+    int k = cfg->k[i];
+    if (k < 1) continue;
+    //k draft steps one token at a time, then one target pass over the k drafts and the last token
+    set_tokens_network(target, k + 1);
+    net_cost v = cost_network(hardware, target);
+    float verify = v.peak_perf;
+    float round = k * step + verify;
+    float produced = expected_tokens(cfg->accept, k);
+    float rate = round > 0 ? batch * produced * 1e6 / round : 0;
+    float speedup = round > 0 ? produced * plain / round : 0;
+    float even = break_even(plain, round, k);
+    printf("%4d  %12.5f  %12.5f  %8.3f  %8s  %10.3f  %12.5f  %12.2f  %8.3f", k, k * step, verify,
+        plain > 0 ? verify / plain : 0, v.alu_perf > v.mem_perf ? "compute" : "memory", produced, round, rate, speedup);
+    if (even < 0) printf("  %10s\n", "never");
+    else printf("  %10.3f\n", even);
+    if (speedup > best_speedup) best_speedup = speedup, best = k;
+  }
+  if (best > 0) printf("\nBest Draft Length      : %d (%.3fx plain decode)\n", best, best_speedup);
+  if (best_speedup <= 1) printf("Speculation doesn't pay off at this acceptance rate on this hardware\n");
+  printf("===========speculative decoding===========\n\n\n");
+}
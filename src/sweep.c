@@ -0,0 +1,207 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sweep.h"
+#include "cost.h"
+#include "mapping.h"
+#include "profile.h"
+#include "utils.h"
+
+//numeric hardware cfg fields a sweep can vary, named as in the cfg
+typedef struct hardware_field {
+    char *key;
+    size_t offset;
+    int is_int;
+} hardware_field;
+
+static hardware_field fields[] = {
+    {"mac_num", offsetof(asic, mac_num), 1},
+    {"mac_rows", offsetof(asic, mac_rows), 1},
+    {"mac_cols", offsetof(asic, mac_cols), 1},
+    {"mac_dtype", offsetof(asic, mac_dtype), 1},
+    {"mac_stall_cycle", offsetof(asic, mac_stall_cycle), 1},
+    {"vec_num", offsetof(asic, vec_num), 1},
+    {"vec_dtype", offsetof(asic, vec_dtype), 1},
+    {"vec_stall_cycle", offsetof(asic, vec_stall_cycle), 1},
+    {"surpass_num", offsetof(asic, surpass_num), 1},
+    {"power", offsetof(asic, pwr), 0},
+    {"static_power", offsetof(asic, static_pwr), 0},
+    {"energy_mac_half", offsetof(asic, energy_mac_half), 0},
+    {"energy_mac_float", offsetof(asic, energy_mac_float), 0},
+    {"energy_vec", offsetof(asic, energy_vec), 0},
+    {"energy_sram", offsetof(asic, energy_sram), 0},
+    {"energy_dram", offsetof(asic, energy_dram), 0},
+    {"offchip_bandwidth", offsetof(asic, off_bw), 0},
+    {"offchip_latency", offsetof(asic, latency), 0},
+    {"outstanding_requests", offsetof(asic, outstanding), 1},
+    {"frequency", offsetof(asic, freq), 0},
+    {"average_alu_efficiency", offsetof(asic, ave_alu_eff), 0},
+    {"average_bandwidth_efficiency", offsetof(asic, ave_bw_eff), 0},
+    {"surpass_efficiency", offsetof(asic, surpass_eff), 0},
+    {"dram_channels", offsetof(asic, dram_channels), 1},
+    {"dram_burst", offsetof(asic, dram_burst), 1},
+    {"dram_page", offsetof(asic, dram_page), 1},
+    {"dram_banks", offsetof(asic, dram_banks), 1},
+    {"dram_row_miss", offsetof(asic, dram_row_miss), 0},
+    {"sram_size", offsetof(asic, sram_size), 1},
+    {0, 0, 0}
+};
+
+static int find_field(char *key) {
+  int i;
+  for (i = 0; fields[i].key; ++i) {
+    if (strcmp(fields[i].key, key) == 0) return i;
+  }
+  return -1;
+}
+
+static void set_field(asic *hardware, int f, float value) {
+  char *p = (char*)hardware + fields[f].offset;
+  if (fields[f].is_int) *(int*)p = (int)(value + 0.5f);
+  else *(float*)p = value;
+}
+
+int set_hardware_field(asic *hardware, char *key, float value) {
+  int f = find_field(key);
+  if (f < 0) return 0;
+  set_field(hardware, f, value);
+  if (has_mac_array(hardware)) hardware->mac_num = hardware->mac_rows * hardware->mac_cols;
+  return 1;
+}
+
+float get_hardware_field(asic *hardware, char *key, int *is_int) {
+  int f = find_field(key);
+  if (f < 0) error("unknown hardware field");
+  char *p = (char*)hardware + fields[f].offset;
+  if (is_int) *is_int = fields[f].is_int;
+  return fields[f].is_int ? *(int*)p : *(float*)p;
+}
+
+void parse_sweep(char *s, sweep_spec *spec) {
+  char *copy = copy_string(s);
+  char *param = copy;
+  memset(spec, 0, sizeof(sweep_spec));
+  spec->points = 1;
+  while (param && *param) {
+    char *next = strchr(param, ';');
+    if (next) *next++ = 0;
+    char *eq = strchr(param, '=');
+    if (!eq) error("--sweep parameters are key=values");
+    *eq = 0;
+    if (spec->n == MAX_SWEEP_PARAMS) error("too many --sweep parameters");
+    int f = find_field(param);
+    if (f < 0) {
+      fprintf(stderr, "%s can't be swept\n", param);
+      error("unknown --sweep parameter");
+    }
+    float *values = (float*)xcalloc(MAX_SWEEP_VALUES, sizeof(float));
+    int n = parse_range_list(eq + 1, values, MAX_SWEEP_VALUES);
+    if (n < 1) error("--sweep parameter without values");
+    spec->keys[spec->n] = fields[f].key;
+    spec->fields[spec->n] = f;
+    spec->nvalues[spec->n] = n;
+    spec->values[spec->n] = values;
+    spec->points *= n;
+    ++spec->n;
+    param = next;
+  }
+  free(copy);
+  if (spec->n == 0) error("empty --sweep");
+}
+
+void free_sweep(sweep_spec *spec) {
+  int i;
+  for (i = 0; i < spec->n; ++i) free(spec->values[i]);
+}
+
+typedef struct sweep_worker {
+    asic *hardware;
+    network *net;
+    sweep_spec *spec;
+    sink *out;
+    long *next;                 //first point nobody has claimed, shared
+    float ops;
+    sink_buffer *buffer;
+    profile_counters counters;
+} sweep_worker;
+
+static void *sweep_thread(void *arg) {
+  sweep_worker *w = (sweep_worker*)arg;
+  sweep_spec *spec = w->spec;
+  asic a = *w->hardware;
+  sink_record r;
+  int p;
+  w->buffer = make_sink_buffer(w->out);
+  memset(&r, 0, sizeof(r));
+  for (;;) {
+    long start = __atomic_fetch_add(w->next, SINK_CHUNK, __ATOMIC_RELAXED);
+    if (start >= spec->points) break;
+    long end = start + SINK_CHUNK < spec->points ? start + SINK_CHUNK : spec->points;
+    long i;
+    for (i = start; i < end; ++i) {
+      long rest = i;
+      for (p = spec->n - 1; p >= 0; --p) {
+        r.value[p] = rest % spec->nvalues[p];
+        rest /= spec->nvalues[p];
+        set_field(&a, spec->fields[p], spec->values[p][r.value[p]]);
+      }
+      if (has_mac_array(&a)) a.mac_num = a.mac_rows * a.mac_cols;
+      net_cost c = cost_network(&a, w->net);
+      r.index = i;
+      r.metric[COL_PEAK] = c.peak_perf;
+      r.metric[COL_WORST] = c.worst_perf;
+      r.metric[COL_ALU] = c.alu_perf;
+      r.metric[COL_MEM] = c.mem_perf;
+      r.metric[COL_ENERGY] = c.energy;
+      r.metric[COL_EFFICIENCY] = c.peak_perf > 0 ? alu_time(&a, TENSOR_UNIT, w->ops, 1) / c.peak_perf : 0;
+      sink_write(w->out, w->buffer, &r);
+    }
+  }
+  sink_flush(w->out, w->buffer);
+  w->counters = prof_count;
+  return 0;
+}
+
+void sweep_report(asic *hardware, network *net, sweep_spec *spec, char *out, int threads, int top) {
+  int p;
+  for (p = 0; p < spec->n; ++p) {
+    if (has_mac_array(hardware) && strcmp(spec->keys[p], "mac_num") == 0) {
+      fprintf(stderr, "mac_num follows mac_rows x mac_cols on an array, sweep those instead\n");
+    }
+  }
+  if (threads < 1) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1) threads = 1;
+  sink *s = open_sink(out, spec->points, spec->n, spec->keys, spec->values, spec->nvalues, top);
+  sweep_worker *workers = (sweep_worker*)xcalloc(threads, sizeof(sweep_worker));
+  pthread_t *tids = (pthread_t*)xcalloc(threads, sizeof(pthread_t));
+  long next = 0;
+  float ops = cost_network(hardware, net).ops;
+  int i;
+  double t0 = what_time_is_it_now();
+  for (i = 0; i < threads; ++i) {
+    workers[i].hardware = hardware;
+    workers[i].net = net;
+    workers[i].spec = spec;
+    workers[i].out = s;
+    workers[i].next = &next;
+    workers[i].ops = ops;
+    if (pthread_create(&tids[i], 0, sweep_thread, &workers[i])) error("pthread_create failed");
+  }
+  for (i = 0; i < threads; ++i) {
+    pthread_join(tids[i], 0);
+    sink_merge(s, workers[i].buffer);
+    profile_add(&workers[i].counters);
+  }
+  double wall = what_time_is_it_now() - t0;
+
+  printf("Sweep Points           : %ld over %d parameters\n", spec->points, spec->n);
+  printf("Threads                : %d\n", threads);
+  printf("Sweep Time             : %.3f s (%.0f points/s)\n\n", wall, wall > 0 ? spec->points / wall : 0);
+  sink_report(s);
+  close_sink(s);
+  free(workers);
+  free(tids);
+}
@@ -0,0 +1,218 @@
+#include <stdlib.h>
+
+#include "tiers.h"
+#include "cost.h"
+#include "network.h"
+#include "train.h"
+#include "utils.h"
+
+char *get_object_string(OBJECT_KIND k) {
+  switch(k) {
+    case OBJ_WEIGHTS:
+      return "weights";
+    case OBJ_KV_CACHE:
+      return "kv cache";
+    case OBJ_EXPERT:
+      return "expert";
+    case OBJ_TABLE:
+      return "table";
+    case OBJ_ACTIVATIONS:
+      return "activations";
+  }
+  return "none";
+}
+
+static placement_object *add_object(placement_object *objs, int *n, OBJECT_KIND kind, int layer, float size, float traffic) {
+  placement_object *o = &objs[*n];
+  if (size <= 0) return 0;
+  memset(o, 0, sizeof(placement_object));
+  o->kind = kind;
+  o->layer = layer;
+  o->size = size;
+  o->traffic = traffic;
+  ++*n;
+  return o;
+}
+
+//every layer's data as objects; the activations of all layers share one arena as large as
+//the largest layer's input and output
+static int build_objects(asic *hardware, network *net, placement_object *objs, float *activation) {
+  int mac_dtype = dtype_size(hardware->mac_dtype);
+  float arena = 0, arena_traffic = 0;
+  int i, e, n = 0;
+  for (i = 0; i < net->n; ++i) {
+    layer *l = &net->layers[i];
+    float blocks = layer_repeats(net, l);
+    layer_cost c = cost_layer(hardware, l);
+    float act = c.mem_in + c.mem_out;
+    if (l->type == ATTENTION) {
+      //a decoding step reads the whole cache, a prefill reads it once as it goes
+      float kv = kv_cache_bytes(hardware, l);
+      add_object(objs, &n, OBJ_KV_CACHE, i, blocks * kv, blocks * (kv < c.mem_in ? kv : c.mem_in));
+      act -= kv < c.mem_in ? kv : c.mem_in;
+    } else if (l->type == MOE) {
+      float loads[MAX_EXPERTS], active[MAX_EXPERTS];
+      float expert = (float)mac_dtype * (l->gated ? 3 : 2) * l->inputs * l->hidden;
+      moe_expected_loads(l, loads, active);
+      add_object(objs, &n, OBJ_WEIGHTS, i, blocks * mac_dtype * (float)l->inputs * l->experts,
+          blocks * mac_dtype * (float)l->inputs * l->experts);
+      for (e = 0; e < l->experts; ++e) {
+        placement_object *o = add_object(objs, &n, OBJ_EXPERT, i, blocks * expert, blocks * active[e] * expert);
+        if (o) o->expert = e;
+      }
+    } else if (l->type == EMBEDDING) {
+      placement_object *o = add_object(objs, &n, OBJ_TABLE, i, blocks * mac_dtype * (float)l->vocab * l->c, blocks * c.mem_in);
+      if (o) o->requests = blocks * c.in_requests;
+      act = c.mem_out;
+    } else if (c.mem_weight > 0) {
+      float size = layer_params(l) * mac_dtype;
+      add_object(objs, &n, OBJ_WEIGHTS, i, blocks * (size > 0 ? size : c.mem_weight), blocks * c.mem_weight);
+    }
+    activation[i] = act;
+    if (act > arena) arena = act;
+    arena_traffic += blocks * act;
+  }
+  add_object(objs, &n, OBJ_ACTIVATIONS, -1, arena, arena_traffic);
+  return n;
+}
+
+static memory_tier *sorted_tiers;
+static int by_bandwidth(const void *a, const void *b) {
+  float x = sorted_tiers[*(int*)a].bw, y = sorted_tiers[*(int*)b].bw;
+  if (x != y) return x > y ? -1 : 1;
+  return *(int*)a - *(int*)b;
+}
+
+static int by_density(const void *a, const void *b) {
+  const placement_object *x = (const placement_object*)a, *y = (const placement_object*)b;
+  float dx = x->traffic / x->size, dy = y->traffic / y->size;
+  if (dx != dy) return dx > dy ? -1 : 1;
+  if (x->layer != y->layer) return x->layer - y->layer;
+  return x->expert - y->expert;
+}
+
+//time to move bytes, requests of them gathers, from one tier
+static float tier_time(asic *hardware, memory_tier *t, float bytes, float requests) {
+  if (bytes <= 0) return 0;
+  float time = bytes / (t->bw * 1024 * 1024 * 1024) * 1e6 / (hardware->ave_bw_eff / 100) + t->latency;
+  float wait = requests * t->latency / hardware->outstanding;
+  return wait > time ? wait : time;
+}
+
+void tiers_report(asic *hardware, network *net) {
+  int ntiers = hardware->tier_num;
+  int order[MAX_TIERS];
+  int i, j, t;
+  if (ntiers == 0) return;
+  int max_objs = 1;
+  for (i = 0; i < net->n; ++i) max_objs += 1 + (net->layers[i].type == MOE ? net->layers[i].experts : 0);
+  placement_object *objs = (placement_object*)xcalloc(max_objs, sizeof(placement_object));
+  float *activation = (float*)xcalloc(net->n > 0 ? net->n : 1, sizeof(float));
+  int n = build_objects(hardware, net, objs, activation);
+
+  //greedy by traffic per byte: the hottest bytes take the fastest tier, an object that
+  //doesn't fit spills its rest to the next tier, and what fits nowhere lands in the last one
+  for (t = 0; t < ntiers; ++t) order[t] = t;
+  sorted_tiers = hardware->tiers;
+  qsort(order, ntiers, sizeof(int), by_bandwidth);
+  qsort(objs, n, sizeof(placement_object), by_density);
+  float free_bytes[MAX_TIERS], capacity = 0, footprint = 0, overflow = 0;
+  for (t = 0; t < ntiers; ++t) {
+    free_bytes[t] = hardware->tiers[t].capacity * 1024 * 1024;
+    capacity += free_bytes[t];
+  }
+  for (i = 0; i < n; ++i) {
+    placement_object *o = &objs[i];
+    float left = o->size;
+    footprint += o->size;
+    for (j = 0; j < ntiers && left > 0; ++j) {
+      t = order[j];
+      float take = left < free_bytes[t] ? left : free_bytes[t];
+      if (take <= 0) continue;
+      o->share[t] += take / o->size;
+      free_bytes[t] -= take;
+      left -= take;
+    }
+    if (left > 0) {
+      o->share[order[ntiers - 1]] += left / o->size;
+      overflow += left;
+    }
+  }
+  if (overflow > 0) {
+    fprintf(stderr, "%.3f MB don't fit in the memory tiers, placing them in %s\n", overflow / (1024 * 1024),
+        hardware->tiers[order[ntiers - 1]].name);
+  }
+
+  //each layer moves its objects' traffic from where they sit, tier after tier
+  float tier_bytes[MAX_TIERS] = {0}, tier_perf[MAX_TIERS] = {0};
+  float arena_share[MAX_TIERS] = {0};
+  for (i = 0; i < n; ++i) {
+    if (objs[i].kind == OBJ_ACTIVATIONS) for (t = 0; t < ntiers; ++t) arena_share[t] = objs[i].share[t];
+  }
+  float mem = 0, alu = 0, energy = 0;
+  for (i = 0; i < net->n; ++i) {
+    layer_cost c = cost_layer(hardware, &net->layers[i]);
+    float blocks = layer_repeats(net, &net->layers[i]);
+    alu += blocks * c.alu_perf;
+    for (t = 0; t < ntiers; ++t) {
+      float bytes = arena_share[t] * blocks * activation[i], requests = 0;
+      for (j = 0; j < n; ++j) {
+        if (objs[j].layer != i) continue;
+        bytes += objs[j].share[t] * objs[j].traffic;
+        requests += objs[j].share[t] * objs[j].requests;
+      }
+      float time = tier_time(hardware, &hardware->tiers[t], bytes, requests);
+      tier_bytes[t] += bytes;
+      tier_perf[t] += time;
+      mem += time;
+      energy += bytes * hardware->tiers[t].energy / 1e6;
+    }
+  }
+  net_cost single = cost_network(hardware, net);
+
+  printf("===========memory tiers===================\n");
+  printf("%-12s  %12s  %12s  %11s  %12s  %8s  %12s  %14s  %12s\n", "Tier", "Capacity(MB)", "Bandwidth", "Latency(us)",
+      "Used(MB)", "Used(%)", "Traffic(MB)", "Time(us)", "Energy(uJ)");
+  for (j = 0; j < ntiers; ++j) {
+    memory_tier *m = &hardware->tiers[order[j]];
+    float used = 0;
+    for (i = 0; i < n; ++i) used += objs[i].share[order[j]] * objs[i].size;
+    printf("%-12s  %12.1f  %7.1f GB/s  %11.5f  %12.3f  %8.2f  %12.3f  %14.5f  %12.5f\n", m->name, m->capacity, m->bw,
+        m->latency, used / (1024 * 1024), m->capacity > 0 ? 100 * used / (m->capacity * 1024 * 1024) : 0,
+        tier_bytes[order[j]] / (1024 * 1024), tier_perf[order[j]], tier_bytes[order[j]] * m->energy / 1e6);
+  }
+
+  //placement, hottest first
+  printf("\n%-22s  %5s  %12s  %12s  %s\n", "Data", "Layer", "Size(MB)", "Traffic(MB)", "Placement");
+  for (i = 0; i < n; ++i) {
+    placement_object *o = &objs[i];
+    char name[64];
+    if (o->kind == OBJ_EXPERT) sprintf(name, "%s %d", get_object_string(o->kind), o->expert);
+    else sprintf(name, "%s", get_object_string(o->kind));
+    if (o->layer < 0) printf("%-22s  %5s", name, "-");
+    else printf("%-22s  %5d", name, o->layer);
+    printf("  %12.3f  %12.3f  ", o->size / (1024 * 1024), o->traffic / (1024 * 1024));
+    int first = 1;
+    for (j = 0; j < ntiers; ++j) {
+      t = order[j];
+      if (o->share[t] <= 0) continue;
+      if (!first) printf(", ");
+      if (o->share[t] >= 0.9995) printf("%s", hardware->tiers[t].name);
+      else printf("%s %.1f%%", hardware->tiers[t].name, 100 * o->share[t]);
+      first = 0;
+    }
+    printf("\n");
+  }
+
+  float placed = alu > mem ? alu : mem;
+  printf("\nBlocks                 : %d\n", net->blocks);
+  printf("Footprint              : %.3f MB of %.3f MB", footprint / (1024 * 1024), capacity / (1024 * 1024));
+  if (footprint > capacity) printf(" (doesn't fit, %.3f MB over)", (footprint - capacity) / (1024 * 1024));
+  printf("\nPlaced Latency         : %.5f us (%s bound)\n", placed, alu > mem ? "compute" : "memory");
+  printf("Single Memory Latency  : %.5f us\n", single.peak_perf);
+  printf("Placement Cost         : %.3fx\n", single.peak_perf > 0 ? placed / single.peak_perf : 0);
+  printf("Tier Energy            : %.5f uJ\n", energy);
+  printf("===========memory tiers===================\n\n\n");
+  free(objs);
+  free(activation);
+}
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "trace.h"
+#include "network.h"
+#include "utils.h"
+
+//tid of the per-layer track, after the alu and dma tracks
+#define LAYER_TRACK NUM_TRACKS
+
+typedef struct counter_delta {
+    double time;
+    double delta;
+} counter_delta;
+
+//counters are written at the 1 ps resolution of the trace, snapping times to it keeps a
+//transfer ending and the next one starting on the same timestamp
+static double snap(double t) {
+  return floor(t * 1e6 + 0.5) / 1e6;
+}
+
+typedef struct dma_start {
+    double start;
+    int id;
+} dma_start;
+
+static int start_comparator(const void *a, const void *b) {
+  double ta = ((dma_start*)a)->start;
+  double tb = ((dma_start*)b)->start;
+  if (ta != tb) return (ta > tb) - (ta < tb);
+  return ((dma_start*)a)->id - ((dma_start*)b)->id;
+}
+
+static int delta_comparator(const void *a, const void *b) {
+  double ta = ((counter_delta*)a)->time;
+  double tb = ((counter_delta*)b)->time;
+  return (ta > tb) - (ta < tb);
+}
+
+static char *track_name(int track) {
+  switch(track) {
+    case TENSOR_UNIT:
+      return "Tensor Alu";
+    case VECTOR_UNIT:
+      return "Vector Alu";
+    case SURPASS_UNIT:
+      return "Surpass Alu";
+  }
+  return "Layers";
+}
+
+static char *inst_name(INST_TYPE type) {
+  switch(type) {
+    case INST_LOAD:
+      return "load";
+    case INST_COMPUTE:
+      return "compute";
+    case INST_STORE:
+      return "store";
+  }
+  return "none";
+}
+
+//a dma slice lasts until its data arrives, offchip_latency after the channel is released, so
+//transfers in flight overlap; each is put on the first lane free at its start, lane 0 is the
+//dma track and lane k > 0 is the thread after the layer track
+static int assign_dma_lanes(timeline *t, int *tid) {
+  dma_start *order = (dma_start*)xcalloc(t->n + 1, sizeof(dma_start));
+  int n = 0;
+  int i;
+  for (i = 0; i < t->n; ++i) {
+    if (t->slices[i].type == INST_COMPUTE) continue;
+    order[n].start = t->slices[i].start;
+    order[n++].id = i;
+  }
+  qsort(order, n, sizeof(dma_start), start_comparator);
+
+  int lanes = 0;
+  int size = 4;
+  double *lane_end = (double*)xcalloc(size, sizeof(double));
+  for (i = 0; i < n; ++i) {
+    slice *s = &t->slices[order[i].id];
+    int k;
+    for (k = 0; k < lanes; ++k) if (lane_end[k] <= s->start) break;
+    if (k == lanes) {
+      if (lanes == size) {
+        size *= 2;
+        lane_end = (double*)xrealloc(lane_end, size * sizeof(double));
+      }
+      ++lanes;
+    }
+    lane_end[k] = s->end;
+    tid[order[i].id] = k == 0 ? DMA_TRACK : LAYER_TRACK + k;
+  }
+  free(order);
+  free(lane_end);
+  return lanes;
+}
+
+//sorts the deltas and writes the running sum as a counter track
+static void write_counter(FILE *fp, char *name, char *unit, counter_delta *d, int n, double scale) {
+  qsort(d, n, sizeof(counter_delta), delta_comparator);
+  double value = 0;
+  int i;
+  for (i = 0; i < n; ++i) {
+    value += d[i].delta;
+    //only the last delta at a timestamp carries the settled value
+    if (i + 1 < n && d[i + 1].time == d[i].time) continue;
+    fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":0,\"ts\":%.6f,\"args\":{\"%s\":%.6f}}",
+        name, d[i].time, unit, value < 0 ? 0 : value * scale);
+  }
+}
+
+void write_trace(char *filename, timeline *t, network *net, asic *hardware) {
+  FILE *fp = fopen(filename, "w");
+  if (!fp) file_error(filename);
+
+  int i;
+  int *tid = (int*)xcalloc(t->n + 1, sizeof(int));
+  for (i = 0; i < t->n; ++i) tid[i] = t->slices[i].track;
+  int lanes = assign_dma_lanes(t, tid);
+
+  fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"simulator\"}}");
+  for (i = 0; i <= LAYER_TRACK; ++i) {
+    if (i == SURPASS_UNIT && hardware->surpass_num == 0) continue;
+    if (i == DMA_TRACK) continue;
+    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        i, track_name(i));
+    fprintf(fp, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+        i, i == LAYER_TRACK ? -1 : i);
+  }
+  for (i = 0; i < lanes || i == 0; ++i) {
+    int lane = i == 0 ? DMA_TRACK : LAYER_TRACK + i;
+    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"DMA %d\"}}",
+        lane, i);
+    fprintf(fp, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+        lane, DMA_TRACK + i);
+  }
+
+  //tile slices, and the extent of every layer for the layer track
+  double *layer_start = (double*)xcalloc(net->n, sizeof(double));
+  double *layer_end = (double*)xcalloc(net->n, sizeof(double));
+  for (i = 0; i < net->n; ++i) layer_start[i] = -1;
+  //a loaded tile holds its buffer until the compute of the same tile ends
+  double *tile_load = (double*)xcalloc(1, sizeof(double));
+  float *tile_bytes = (float*)xcalloc(1, sizeof(float));
+  int tiles = 1;
+
+  counter_delta *bw = (counter_delta*)xcalloc(2 * t->n + 1, sizeof(counter_delta));
+  counter_delta *buf = (counter_delta*)xcalloc(2 * t->n + 1, sizeof(counter_delta));
+  int nbw = 0;
+  int nbuf = 0;
+
+  for (i = 0; i < t->n; ++i) {
+    slice *s = &t->slices[i];
+    double dur = s->end - s->start;
+    fprintf(fp, ",\n{\"name\":\"%s %d %s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+        "\"ts\":%.6f,\"dur\":%.6f,\"args\":{\"layer\":%d,\"tile\":%d,\"%s\":%.0f}}",
+        get_layer_string(net->layers[s->layer].type), s->layer, inst_name(s->type), inst_name(s->type),
+        tid[i], s->start, dur, s->layer, s->tile, s->type == INST_COMPUTE ? "ops" : "bytes", s->amount);
+
+    if (layer_start[s->layer] < 0 || s->start < layer_start[s->layer]) layer_start[s->layer] = s->start;
+    if (s->end > layer_end[s->layer]) layer_end[s->layer] = s->end;
+
+    //dma slices end when the data arrives, the channels were only busy until offchip_latency before
+    double xfer = dur - hardware->latency;
+    if (s->type != INST_COMPUTE && xfer > 0) {
+      bw[nbw].time = snap(s->start);
+      bw[nbw++].delta = s->amount / xfer;
+      bw[nbw].time = snap(s->start + xfer);
+      bw[nbw++].delta = -s->amount / xfer;
+    }
+    if (s->tile >= tiles) {
+      int old = tiles;
+      while (s->tile >= tiles) tiles *= 2;
+      tile_load = (double*)xrealloc(tile_load, tiles * sizeof(double));
+      tile_bytes = (float*)xrealloc(tile_bytes, tiles * sizeof(float));
+      for (; old < tiles; ++old) tile_bytes[old] = 0;
+    }
+    if (s->type == INST_LOAD) {
+      tile_load[s->tile] = s->start;
+      tile_bytes[s->tile] = s->amount;
+    } else if (s->type == INST_COMPUTE && tile_bytes[s->tile] > 0) {
+      buf[nbuf].time = snap(tile_load[s->tile]);
+      buf[nbuf++].delta = tile_bytes[s->tile];
+      buf[nbuf].time = snap(s->end);
+      buf[nbuf++].delta = -tile_bytes[s->tile];
+      tile_bytes[s->tile] = 0;
+    }
+  }
+
+  for (i = 0; i < net->n; ++i) {
+    if (layer_start[i] < 0) continue;
+    fprintf(fp, ",\n{\"name\":\"%s %d\",\"cat\":\"layer\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+        "\"ts\":%.6f,\"dur\":%.6f,\"args\":{\"layer\":%d}}",
+        get_layer_string(net->layers[i].type), i, LAYER_TRACK, layer_start[i], layer_end[i] - layer_start[i], i);
+  }
+
+  //bytes per us is MB/s
+  write_counter(fp, "Offchip Bandwidth", "GB/s", bw, nbw, 1.0 / 1000);
+  write_counter(fp, "Buffer Occupancy", "KB", buf, nbuf, 1.0 / 1024);
+  fprintf(fp, "\n]}\n");
+  fclose(fp);
+
+  free(tid);
+  free(layer_start);
+  free(layer_end);
+  free(tile_load);
+  free(tile_bytes);
+  free(bw);
+  free(buf);
+}
@@ -0,0 +1,249 @@
+#include <math.h>
+#include <string.h>
+
+#include "train.h"
+#include "cost.h"
+#include "dram.h"
+#include "network.h"
+#include "utils.h"
+
+OPTIMIZER get_optimizer(char *s) {
+  if (strcmp(s, "sgd") == 0) return SGD;
+  if (strcmp(s, "momentum") == 0) return MOMENTUM;
+  if (strcmp(s, "adam") == 0) return ADAM;
+  fprintf(stderr, "Couldn't find optimizer %s, going with adam\n", s);
+  return ADAM;
+}
+
+char *get_optimizer_string(OPTIMIZER o) {
+  switch(o) {
+    case SGD:
+      return "sgd";
+    case MOMENTUM:
+      return "momentum";
+    case ADAM:
+      return "adam";
+  }
+  return "none";
+}
+
+RECOMPUTE get_recompute(char *s) {
+  if (strcmp(s, "none") == 0) return RECOMPUTE_NONE;
+  if (strcmp(s, "attention") == 0) return RECOMPUTE_ATTENTION;
+  if (strcmp(s, "checkpoint") == 0) return RECOMPUTE_CHECKPOINT;
+  fprintf(stderr, "Couldn't find recompute policy %s, going with none\n", s);
+  return RECOMPUTE_NONE;
+}
+
+char *get_recompute_string(RECOMPUTE r) {
+  switch(r) {
+    case RECOMPUTE_NONE:
+      return "none";
+    case RECOMPUTE_ATTENTION:
+      return "attention";
+    case RECOMPUTE_CHECKPOINT:
+      return "checkpoint";
+  }
+  return "none";
+}
+
+static float gemm_params(layer *l) {
+  return l ? (float)l->inputs * l->outputs : 0;
+}
+
+float layer_params(layer *l) {
+  int groups = l->groups > 0 ? l->groups : 1;
+  switch(l->type) {
+    case CONVOLUTIONAL:
+      return (float)l->size * l->size * (l->c / groups) * l->n;
+    case DECONV:
+      return (float)l->size * l->size * l->c * l->n;
+    case CONNECTED:
+      return gemm_params(l);
+    case RNN:
+      return gemm_params(l->input_layer) + gemm_params(l->self_layer) + gemm_params(l->output_layer);
+    case LSTM:
+      return gemm_params(l->uf) + gemm_params(l->ui) + gemm_params(l->ug) + gemm_params(l->uo)
+           + gemm_params(l->wf) + gemm_params(l->wi) + gemm_params(l->wg) + gemm_params(l->wo);
+    case MOE:
+      return (float)l->inputs * l->experts + (float)l->experts * (l->gated ? 3 : 2) * l->inputs * l->hidden;
+    case EMBEDDING:
+      return (float)l->vocab * l->c;
+    case BATCHNORM:
+      return 2.0 * l->c;
+    default:
+      break;
+  }
+  return 0;
+}
+
+static int has_weights(layer *l) {
+  return l->type == CONVOLUTIONAL || l->type == DECONV || l->type == CONNECTED || l->type == RNN || l->type == LSTM || l->type == MOE;
+}
+
+//forward activations the backward pass of a layer reads, for the whole batch
+static float activation_bytes(asic *hardware, layer *l, int probabilities) {
+  int dtype = dtype_size(hardware->vec_dtype);
+  float batch = l->batch > 0 ? l->batch : 1;
+  float tokens = l->seq_len > 0 ? l->seq_len : 1;
+  float bytes = (float)l->inputs * batch * tokens;
+  if (l->type == CONVOLUTIONAL || l->type == MAXPOOL || l->type == AVGPOOL || l->type == LRN) {
+    bytes = (float)l->h * l->w * l->c * batch;
+  }
+  if (l->type == RNN || l->type == LSTM) {
+    //every step's x, and its gates and cell state (lstm) or h (rnn)
+    int steps = l->n > 0 ? l->n : 1;
+    bytes = (float)steps * batch * (l->inputs + (l->type == LSTM ? 5 : 1) * l->outputs);
+  }
+  //tiled attention keeps only the row sums and recomputes the scores block by block
+  if (l->type == ATTENTION && probabilities && !l->flash) {
+    bytes += batch * l->heads * tokens * attention_span(l);
+  }
+  if (l->type == ROUTE) bytes = 0;
+  return bytes * dtype;
+}
+
+//traffic, work and time of one phase of the step, summed over layers
+typedef struct phase {
+    char *name;
+    float ops;
+    float mem;
+    float alu_perf;
+    float mem_perf;
+} phase;
+
+//bytes moved at the layer's achieved bandwidth in the forward pass
+static float layer_mem_time(asic *hardware, layer_cost *c, float bytes) {
+  if (c->mem > 0 && c->mem_perf > 0) return bytes * c->mem_perf / c->mem;
+  return mem_time(hardware, bytes, dram_efficiency(hardware, SEQUENTIAL, bytes, 0));
+}
+
+static void add_phase(phase *p, float ops, float mem, float alu_perf, float mem_perf) {
+  p->ops += ops;
+  p->mem += mem;
+  p->alu_perf += alu_perf;
+  p->mem_perf += mem_perf;
+}
+
+void training_report(asic *hardware, network *net, train_config *cfg) {
+  enum {FORWARD, RECOMPUTE, BACKWARD_DATA, BACKWARD_WEIGHT, UPDATE, NUM_PHASES};
+  phase phases[NUM_PHASES] = {{"forward"}, {"recompute"}, {"backward data"}, {"backward weight"}, {"optimizer"}};
+  int mac_dtype = dtype_size(hardware->mac_dtype);
+  float vec_eff = unit_efficiency(hardware, VECTOR_UNIT) / 100 * pipe_efficiency(hardware, VECTOR_UNIT);
+  float params = 0;
+  float stash = 0, working = 0;
+  int i, b, k;
+  int blocks = net->blocks > 0 ? net->blocks : 1;
+  int runs = 0;
+  for (i = 0; i < net->n; ++i) runs += layer_repeats(net, &net->layers[i]);
+  int segment = (int)ceil(sqrt(runs > 0 ? runs : 1));
+  float segment_bytes = 0, largest_segment = 0;
+
+  //the whole model is its blocks one after another, a layer run once per model is in the first
+  for (b = 0, k = 0; b < blocks; ++b) {
+    for (i = 0; i < net->n; ++i) {
+      layer *l = &net->layers[i];
+      if (b > 0 && l->once) continue;
+      int pos = k++;
+      layer_cost c = cost_layer(hardware, l);
+      add_phase(&phases[FORWARD], c.ops, c.mem, c.alu_perf, c.mem_perf);
+      params += layer_params(l);
+
+      //what stays in memory for the backward pass
+      int recompute_probabilities = cfg->recompute == RECOMPUTE_ATTENTION && l->type == ATTENTION;
+      float act = activation_bytes(hardware, l, !recompute_probabilities);
+      if (cfg->recompute == RECOMPUTE_CHECKPOINT) {
+        if (pos % segment == 0) {
+          stash += activation_bytes(hardware, l, 0);
+          segment_bytes = 0;
+        }
+        segment_bytes += act;
+        if (segment_bytes > largest_segment) largest_segment = segment_bytes;
+      } else {
+        stash += act;
+      }
+      //forward work done again before the backward pass needs it
+      if (cfg->recompute == RECOMPUTE_CHECKPOINT || recompute_probabilities) {
+        add_phase(&phases[RECOMPUTE], c.ops, c.mem, c.alu_perf, c.mem_perf);
+      }
+
+      //gradients flow in as dy (the forward output) and out as dx (the forward input)
+      float dy = c.mem_out, dx = c.mem_in, stashed = c.mem_in;
+      float gemm_x = l->type == ATTENTION ? 2 : 1;
+      if (l->type == BATCHNORM) gemm_x = 2;
+      if (working < dx + dy) working = dx + dy;
+      if (has_weights(l)) {
+        //dx = dy . W^T and dW = x^T . dy, each as much work as the forward gemm
+        if (pos > 0) {
+          float mem = dy + c.mem_weight + dx;
+          add_phase(&phases[BACKWARD_DATA], c.ops, mem, c.alu_perf, layer_mem_time(hardware, &c, mem));
+        }
+        float dw = layer_params(l) * mac_dtype;
+        float mem = dy + stashed + dw;
+        add_phase(&phases[BACKWARD_WEIGHT], c.ops, mem, c.alu_perf, layer_mem_time(hardware, &c, mem));
+      } else if (l->type == EMBEDDING) {
+        //the ids need no dx; each gathered row's dy is added back into its row of the table
+        float rows = (float)l->lookups * (l->batch > 0 ? l->batch : 1) * (l->seq_len > 0 ? l->seq_len : 1);
+        float ops = rows * l->c;
+        float mem = dy + 2.0 * ops * mac_dtype;
+        add_phase(&phases[BACKWARD_WEIGHT], ops, mem, alu_time(hardware, VECTOR_UNIT, ops, vec_eff),
+            layer_mem_time(hardware, &c, mem));
+      } else if (pos > 0 && l->type != ROUTE) {
+        //elementwise and pooling layers read dy and what they stashed and write dx; attention
+        //runs dq, dk, dv and the softmax backward, twice its forward work
+        float mem = l->type == ATTENTION ? 2 * c.mem : dy + stashed + dx;
+        add_phase(&phases[BACKWARD_DATA], gemm_x * c.ops, mem, gemm_x * c.alu_perf,
+            layer_mem_time(hardware, &c, mem));
+      }
+      if (l->type == BATCHNORM) {
+        //dgamma and dbeta reduce dy * x_hat and dy per channel, fused with the dx pass that
+        //already reads them, so only the two gradients are written
+        float ops = 3.0 * c.mem_in / dtype_size(hardware->vec_dtype);
+        float mem = layer_params(l) * mac_dtype;
+        add_phase(&phases[BACKWARD_WEIGHT], ops, mem, alu_time(hardware, VECTOR_UNIT, ops, vec_eff),
+            layer_mem_time(hardware, &c, mem));
+      }
+    }
+  }
+  stash += largest_segment;
+
+  //the update streams weights and gradients, plus fp32 optimizer state
+  int states = cfg->optimizer == ADAM ? 2 : cfg->optimizer == MOMENTUM ? 1 : 0;
+  float update_ops = params * (cfg->optimizer == ADAM ? 12 : cfg->optimizer == MOMENTUM ? 4 : 2);
+  float update_mem = params * (3.0 * mac_dtype + states * 2 * 4);
+  add_phase(&phases[UPDATE], update_ops, update_mem, alu_time(hardware, VECTOR_UNIT, update_ops, vec_eff),
+      mem_time(hardware, update_mem, dram_efficiency(hardware, SEQUENTIAL, update_mem, 0)));
+
+  float alu = 0, mem = 0, bytes = 0;
+  int p;
+  printf("===========training=======================\n");
+  printf("Optimizer              : %s\n", get_optimizer_string(cfg->optimizer));
+  printf("Recompute              : %s", get_recompute_string(cfg->recompute));
+  if (cfg->recompute == RECOMPUTE_CHECKPOINT) printf(" (every %d layers)", segment);
+  if (net->blocks > 1) printf("\nBlocks                 : %d", net->blocks);
+  printf("\nParameters             : %.3f M\n\n", params / 1e6);
+  printf("%-16s  %10s  %12s  %14s  %14s  %8s\n", "Phase", "GOPs", "Data(MB)", "Compute(us)", "Memory(us)", "Bound");
+  for (p = 0; p < NUM_PHASES; ++p) {
+    phase *ph = &phases[p];
+    if (ph->ops == 0 && ph->mem == 0) continue;
+    printf("%-16s  %10.3f  %12.3f  %14.5f  %14.5f  %8s\n", ph->name, ph->ops / 1e9, ph->mem / (1024 * 1024),
+        ph->alu_perf, ph->mem_perf, ph->alu_perf > ph->mem_perf ? "compute" : "memory");
+    alu += ph->alu_perf;
+    mem += ph->mem_perf;
+    bytes += ph->mem;
+  }
+  float weights = params * mac_dtype;
+  float optimizer = params * states * 4;
+  printf("\nStep Time              : %.5f us (compute and memory overlapped)\n", alu > mem ? alu : mem);
+  printf("Step Time Worst        : %.5f us\n", alu + mem);
+  printf("Forward Share          : %.2f%%\n", 100 * (phases[FORWARD].alu_perf > phases[FORWARD].mem_perf ?
+      phases[FORWARD].alu_perf : phases[FORWARD].mem_perf) / (alu > mem ? alu : mem));
+  printf("Traffic vs Forward     : %.2fx\n", phases[FORWARD].mem > 0 ? bytes / phases[FORWARD].mem : 0);
+  printf("Bottleneck             : %s\n", alu > mem ? "COMPUTATION" : "MEMORY ACCESS");
+  printf("Peak Memory            : %.3f MB\n", (weights * 2 + optimizer + stash + working) / (1024 * 1024));
+  printf("  weights/gradients    : %.3f / %.3f MB\n", weights / (1024 * 1024), weights / (1024 * 1024));
+  printf("  optimizer state      : %.3f MB\n", optimizer / (1024 * 1024));
+  printf("  stashed activations  : %.3f MB\n", stash / (1024 * 1024));
+  printf("  largest dx + dy      : %.3f MB\n", working / (1024 * 1024));
+  printf("===========training=======================\n\n\n");
+}
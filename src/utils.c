@@ -3,6 +3,7 @@
 #endif
 
 #include "utils.h"
+#include "profile.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,7 +24,15 @@
 #pragma warning(disable: 4996)
 #endif
 
+double what_time_is_it_now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec*1e-9;
+}
+
 void *xmalloc(size_t size) {
+  ++prof_count.allocations;
+  prof_count.allocated += size;
   void *ptr=malloc(size);
   if(!ptr) {
     malloc_error();
@@ -32,6 +41,8 @@ void *xmalloc(size_t size) {
 }
 
 void *xcalloc(size_t nmemb, size_t size) {
+  ++prof_count.allocations;
+  prof_count.allocated += nmemb * size;
   void *ptr=calloc(nmemb,size);
   if(!ptr) {
     calloc_error();
@@ -40,6 +51,8 @@ void *xcalloc(size_t nmemb, size_t size) {
 }
 
 void *xrealloc(void *ptr, size_t size) {
+  ++prof_count.allocations;
+  prof_count.allocated += size;
   ptr=realloc(ptr,size);
   if(!ptr) {
     realloc_error();
@@ -276,6 +289,35 @@ char *fgetl(FILE *fp) {
   return line;
 }
 
+int parse_float_list(char *s, float *out, int max) {
+  if (!s) return 0;
+  char *list = s;
+  int n = 0;
+  while (n < max) {
+    out[n++] = atof(s);
+    s = strchr(s, ',');
+    if (!s) break;
+    ++s;
+  }
+  if (s && n == max) fprintf(stderr, "Only the first %d values of '%s' are used\n", max, list);
+  return n;
+}
+
+int parse_range_list(char *s, float *out, int max) {
+  float lo, hi;
+  int n, k;
+  if (s && sscanf(s, "%f:%f:%d", &lo, &hi, &n) == 3) {
+    if (n < 1) return 0;
+    if (n > max) {
+      fprintf(stderr, "Only the first %d values of '%s' are used\n", max, s);
+      n = max;
+    }
+    for (k = 0; k < n; ++k) out[k] = n > 1 ? lo + (hi - lo) * k / (n - 1) : lo;
+    return n;
+  }
+  return parse_float_list(s, out, max);
+}
+
 char *copy_string(char *s) {
   if(!s) {
     return NULL;